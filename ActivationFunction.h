@@ -25,12 +25,35 @@
 #ifndef ACTIVATION_FUNCTION_H_
 #define ACTIVATION_FUNCTION_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "ActivationId.h"
+#include "FastHyperbolicTangent.h"
+#include "FastLogisticFunction.h"
+#include "HyperbolicTangent.h"
+#include "IdentityFunction.h"
+#include "LogisticFunction.h"
+#include "Rectifier.h"
+#include "SoftmaxFunction.h"
+
 namespace mlp {
 
 /// Lightweight template class representing an activation function
 /**
 	An activation function object is a pair of function pointers representing
-	a base function and its derivative.
+	a base function and its derivative, along with an identifier of the
+	wrapped function. Single values are always processed through the
+	pointers. Whole ranges are processed by `apply` and `applyDerivative`,
+	which dispatch once on the identifier to a loop over the statically
+	known built-in function, so that it may be inlined and vectorized;
+	only custom functions are called through the pointers. Derivatives of
+	built-in functions are computed from the cached function values rather
+	than from the arguments, which avoids evaluating transcendental
+	functions a second time during backpropagation. Softmax, which
+	normalizes over a whole layer, is only meaningful when processing
+	ranges; batches of layers are processed by `applyBatch`.
 
 	@tparam T Value type of the function; any copyable type
 */
@@ -46,23 +69,44 @@ public:
 	/// Constructor from wrapped function
 	template<class WrappedFunction>
 	ActivationFunction(const WrappedFunction&);
+	/// Constructor from identifier of a built-in function
+	explicit ActivationFunction(ActivationId id);
 	/// Assigns underlying function
 	template<class WrappedFunction>
-	T operator=(const WrappedFunction&);
+	ActivationFunction& operator=(const WrappedFunction&);
+	/// Obtains identifier of the wrapped function
+	ActivationId id() const;
 	/// Calls the function and returns a value
 	T operator()(T x) const;
 	/// Calls the derivative of the function and returns a value
 	T derivative(T x) const;
+	/// Calls the function for each element of a range
+	void apply(const T* first, std::size_t count, T* out) const;
+	/// Calls the function for each of a number of consecutive ranges
+	void applyBatch(const T* first, std::size_t batchSize, std::size_t count, T* out) const;
+	/// Multiplies each factor by the derivative in the corresponding argument
+	void applyDerivative(const T* first, const T* values, std::size_t count, T* factors) const;
 private:
+	template<class WrappedFunction, class = void>
+	struct IdOf : std::integral_constant<ActivationId, ActivationId::custom> {};
+	template<class WrappedFunction>
+	struct IdOf<WrappedFunction, std::void_t<decltype(WrappedFunction::id)>>
+		: std::integral_constant<ActivationId, WrappedFunction::id> {};
+	template<class Function>
+	static void applyStatic(const T* first, std::size_t count, T* out);
+	template<class Function>
+	static void applyDerivativeStatic(const T* values, std::size_t count, T* factors);
 	FunctionType f;
 	FunctionType df;
+	ActivationId identifier = ActivationId::custom;
 };
 
 /**
 	Constructs an object wrapping static functions of class `WrappedFunction`.
 	`WrappedFunction::f` is used to initialize the base function whereas
-	`WrappedFunction::df` initializes the derivate. The actual argument value
-	is unused.
+	`WrappedFunction::df` initializes the derivate. If `WrappedFunction` has
+	a static member `id`, it is used as the identifier; otherwise the
+	function is considered custom. The actual argument value is unused.
 
 	@tparam WrappedFunction A class type with static members `f` and `df` of
 	                        type assignable to `FunctionType`
@@ -70,21 +114,73 @@ private:
 template<typename T>
 template<class WrappedFunction>
 ActivationFunction<T>::ActivationFunction(const WrappedFunction&)
-	: f(WrappedFunction::f), df(WrappedFunction::df) {}
+	: f(WrappedFunction::f), df(WrappedFunction::df), identifier(IdOf<WrappedFunction>::value) {}
+
+/**
+	Constructs an object wrapping the built-in function identified by `id`,
+	e.g. one read from a file.
+
+	@param[in] id Identifier of a built-in function
+
+	@throws std::invalid_argument If `id` does not identify a built-in
+	                              function
+*/
+template<typename T>
+ActivationFunction<T>::ActivationFunction(ActivationId id) {
+	switch (id) {
+	case ActivationId::identity:
+		*this = IdentityFunction<T>();
+		break;
+	case ActivationId::logistic:
+		*this = LogisticFunction<T>();
+		break;
+	case ActivationId::hyperbolicTangent:
+		*this = HyperbolicTangent<T>();
+		break;
+	case ActivationId::rectifier:
+		*this = Rectifier<T>();
+		break;
+	case ActivationId::fastLogistic:
+		*this = FastLogisticFunction<T>();
+		break;
+	case ActivationId::fastHyperbolicTangent:
+		*this = FastHyperbolicTangent<T>();
+		break;
+	case ActivationId::softmax:
+		*this = SoftmaxFunction<T>();
+		break;
+	default:
+		throw std::invalid_argument("not a built-in activation function");
+	}
+}
 
 /**
 	Wraps static functions of class `WrappedFunction`. `WrappedFunction::f` is
 	assigned to the base function whereas `WrappedFunction::df` is assigned to
-	the derivate. The actual argument value is unused.
+	the derivate. The identifier is determined as by the constructor. The
+	actual argument value is unused.
 
 	@tparam WrappedFunction A class type with static members `f` and `df` of
 	                        type assignable to `FunctionType`
+
+	@returns `*this`
 */
 template<typename T>
 template<class WrappedFunction>
-T ActivationFunction<T>::operator=(const WrappedFunction&) {
+ActivationFunction<T>& ActivationFunction<T>::operator=(const WrappedFunction&) {
 	f = WrappedFunction::f;
 	df = WrappedFunction::df;
+	identifier = IdOf<WrappedFunction>::value;
+	return *this;
+}
+
+/**
+	@returns Identifier of the wrapped function, or `ActivationId::custom`
+	         if it is not a built-in function
+*/
+template<typename T>
+ActivationId ActivationFunction<T>::id() const {
+	return identifier;
 }
 
 /**
@@ -115,6 +211,120 @@ T ActivationFunction<T>::derivative(T x) const {
 	return df(x);
 }
 
+/**
+	Stores the function value in each element of `[first, first + count)`
+	in the corresponding element of the range beginning at `out`. The
+	ranges may be equal but must not otherwise overlap.
+
+	@param[in]  first The beginning of the argument range
+	@param[in]  count Number of arguments
+	@param[out] out   The beginning of the destination range
+*/
+template<typename T>
+void ActivationFunction<T>::apply(const T* first, std::size_t count, T* out) const {
+	switch (identifier) {
+	case ActivationId::identity:
+		return applyStatic<IdentityFunction<T>>(first, count, out);
+	case ActivationId::logistic:
+		return applyStatic<LogisticFunction<T>>(first, count, out);
+	case ActivationId::hyperbolicTangent:
+		return applyStatic<HyperbolicTangent<T>>(first, count, out);
+	case ActivationId::rectifier:
+		return applyStatic<Rectifier<T>>(first, count, out);
+	case ActivationId::fastLogistic:
+		return kernels::fastLogistic(first, count, out);
+	case ActivationId::fastHyperbolicTangent:
+		return kernels::fastTanh(first, count, out);
+	case ActivationId::softmax:
+		return SoftmaxFunction<T>::apply(first, count, out);
+	default:
+		std::transform(first, first + count, out, f);
+	}
+}
+
+/**
+	Behaves like `apply` called for each of `batchSize` consecutive ranges
+	of `count` arguments, as produced by a layer for a batch of inputs.
+	Elementwise functions process the whole batch at once.
+
+	@param[in]  first     The beginning of the argument range
+	@param[in]  batchSize Number of ranges
+	@param[in]  count     Number of arguments in each range
+	@param[out] out       The beginning of the destination range
+*/
+template<typename T>
+void ActivationFunction<T>::applyBatch(const T* first, std::size_t batchSize, std::size_t count, T* out) const {
+	if (identifier != ActivationId::softmax)
+		return apply(first, batchSize * count, out);
+	for (std::size_t i = 0; i < batchSize; ++i) {
+		SoftmaxFunction<T>::apply(first + i * count, count, out + i * count);
+	}
+}
+
+/**
+	Multiplies each element of the range `[factors, factors + count)` by
+	the derivative in the corresponding element of the range beginning at
+	`first`, as required by backpropagation. Built-in functions compute
+	the derivative from the function values previously obtained by `apply`
+	and ignore the arguments; custom functions do the opposite. For
+	softmax, the factors are multiplied by its Jacobian instead.
+
+	@param[in]     first   The beginning of the argument range
+	@param[in]     values  The beginning of the range of function values
+	                       in the corresponding arguments
+	@param[in]     count   Number of arguments
+	@param[in,out] factors The beginning of the factor range
+*/
+template<typename T>
+void ActivationFunction<T>::applyDerivative(const T* first, const T* values, std::size_t count, T* factors) const {
+	switch (identifier) {
+	case ActivationId::identity:
+		return;
+	case ActivationId::logistic:
+		return applyDerivativeStatic<LogisticFunction<T>>(values, count, factors);
+	case ActivationId::hyperbolicTangent:
+		return applyDerivativeStatic<HyperbolicTangent<T>>(values, count, factors);
+	case ActivationId::rectifier:
+		return applyDerivativeStatic<Rectifier<T>>(values, count, factors);
+	case ActivationId::fastLogistic:
+		return applyDerivativeStatic<FastLogisticFunction<T>>(values, count, factors);
+	case ActivationId::fastHyperbolicTangent:
+		return applyDerivativeStatic<FastHyperbolicTangent<T>>(values, count, factors);
+	case ActivationId::softmax:
+		return SoftmaxFunction<T>::applyDerivative(values, count, factors);
+	default:
+		for (std::size_t i = 0; i < count; ++i) {
+			factors[i] *= df(first[i]);
+		}
+	}
+}
+
+/**
+	Loop body of `apply` for a statically known function.
+
+	@tparam Function A class type with a static member `f`
+*/
+template<typename T>
+template<class Function>
+void ActivationFunction<T>::applyStatic(const T* first, std::size_t count, T* out) {
+	for (std::size_t i = 0; i < count; ++i) {
+		out[i] = Function::f(first[i]);
+	}
+}
+
+/**
+	Loop body of `applyDerivative` for a statically known function.
+
+	@tparam Function A class type with a static member `dfy`
+*/
+template<typename T>
+template<class Function>
+void ActivationFunction<T>::applyDerivativeStatic(const T* values, std::size_t count, T* factors) {
+	for (std::size_t i = 0; i < count; ++i) {
+		factors[i] *= Function::dfy(values[i]);
+	}
+}
+
 }
 
 #endif
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef ACTIVATION_ID_H_
+#define ACTIVATION_ID_H_
+
+namespace mlp {
+
+/// Identifiers of built-in activation functions
+/**
+	Built-in activation function classes expose their identifier as
+	a static member `id`, which lets `ActivationFunction` recognize them
+	and process whole layers without indirect calls. The numeric values
+	are stable and may be stored.
+*/
+enum class ActivationId : unsigned char {
+	/// Any function not listed below
+	custom = 0,
+	/// `IdentityFunction`
+	identity = 1,
+	/// `LogisticFunction`
+	logistic = 2,
+	/// `HyperbolicTangent`
+	hyperbolicTangent = 3,
+	/// `Rectifier`
+	rectifier = 4,
+	/// `FastLogisticFunction`
+	fastLogistic = 5,
+	/// `FastHyperbolicTangent`
+	fastHyperbolicTangent = 6,
+	/// `SoftmaxFunction`
+	softmax = 7,
+};
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef ALIGNED_ALLOCATOR_H_
+#define ALIGNED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace mlp {
+
+/// Template class representing an allocator of over-aligned storage
+/**
+	Allocates storage aligned to at least `Alignment` bytes, which allows
+	vectorized kernels to operate on whole cache lines. Meets the requirements
+	of `Allocator`.
+
+	@tparam T         Type of allocated objects
+	@tparam Alignment Alignment of allocated storage in bytes; must be a power
+	                  of two
+*/
+template<typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+	/// Type of allocated objects
+	using value_type = T;
+	/// Alignment of allocated storage in bytes
+	static constexpr std::size_t alignment = Alignment < alignof(T) ? alignof(T) : Alignment;
+	/// Rebinds the allocator to another type
+	template<typename U>
+	struct rebind {
+		/// Rebound allocator type
+		using other = AlignedAllocator<U, Alignment>;
+	};
+	/// Default constructor
+	AlignedAllocator() noexcept = default;
+	/// Converting constructor
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+	/// Obtains the largest number of objects storage can be requested for
+	std::size_t max_size() const noexcept;
+	/// Allocates storage for `n` objects
+	T* allocate(std::size_t n);
+	/// Deallocates storage obtained from `allocate`
+	void deallocate(T* p, std::size_t n) noexcept;
+};
+
+/**
+	@returns The largest `n` for which `n * sizeof(T)` does not overflow
+*/
+template<typename T, std::size_t Alignment>
+std::size_t AlignedAllocator<T, Alignment>::max_size() const noexcept {
+	return std::numeric_limits<std::size_t>::max() / sizeof(T);
+}
+
+/**
+	@param[in] n Number of objects to allocate storage for
+
+	@returns Pointer to the beginning of the allocated storage
+
+	@throws std::bad_array_new_length If `n` exceeds `max_size()`
+	@throws std::bad_alloc            If the storage cannot be allocated
+*/
+template<typename T, std::size_t Alignment>
+T* AlignedAllocator<T, Alignment>::allocate(std::size_t n) {
+	if (n > max_size()) {
+		throw std::bad_array_new_length();
+	}
+	return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+}
+
+/**
+	@param[in] p Pointer obtained from a call to `allocate`
+	@param[in] n Number of objects passed to that call
+*/
+template<typename T, std::size_t Alignment>
+void AlignedAllocator<T, Alignment>::deallocate(T* p, std::size_t) noexcept {
+	::operator delete(p, std::align_val_t(alignment));
+}
+
+/// Compares two aligned allocators for equality
+template<typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) noexcept {
+	return true;
+}
+
+/// Compares two aligned allocators for inequality
+template<typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) noexcept {
+	return false;
+}
+
+/// Vector with storage aligned to cache lines
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+}
+
+#endif
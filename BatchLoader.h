@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef BATCH_LOADER_H_
+#define BATCH_LOADER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "DataSet.h"
+#include "SpscQueue.h"
+
+namespace mlp {
+
+/// Template class preparing training batches on a background thread
+/**
+	A batch loader runs a producer thread that, for every epoch, reorders
+	the tests of a data set and gathers consecutive batches of them into
+	packed, contiguous buffers. Filled buffers are handed to the consumer
+	through a lock-free queue and returned through another one once
+	consumed, so with at least two buffers the next batch is prepared while
+	the current one is being trained on. Both threads spin briefly and then
+	sleep while waiting, which only happens when one side is persistently
+	slower than the other.
+
+	@tparam T Data type of stored values
+*/
+template<typename T>
+class BatchLoader {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Structure holding a packed batch
+	struct Slot {
+		/// Inputs of the tests of the batch
+		AlignedVector<T> inputs;
+		/// Expected outputs of the tests of the batch
+		AlignedVector<T> outputs;
+		/// Number of tests in the batch
+		std::size_t size = 0;
+		/// Whether the batch is the last one of its epoch
+		bool lastOfEpoch = false;
+	};
+	/// Starts the producer thread
+	template<class Source>
+	BatchLoader(const Source& source, std::size_t batchSize, std::size_t epochs, std::size_t bufferCount, std::function<void(std::vector<std::size_t>&)> reorder);
+	/// Copy constructor (deleted)
+	BatchLoader(const BatchLoader&) = delete;
+	/// Copy assignment operator (deleted)
+	BatchLoader& operator=(const BatchLoader&) = delete;
+	/// Stops and joins the producer thread
+	~BatchLoader();
+	/// Waits for the next batch
+	const Slot* acquire();
+	/// Returns the most recently acquired batch to the producer
+	void release();
+	/// Obtains a view of a packed batch
+	typename DataSet<T>::Batch view(const Slot& slot) const;
+private:
+	template<class Source>
+	void produce(const Source& source, std::size_t batchSize, std::size_t epochs);
+	static void backOff(std::size_t& attempts);
+	std::size_t inSize;
+	std::size_t outSize;
+	std::vector<Slot> slots;
+	SpscQueue<std::size_t> ready;
+	SpscQueue<std::size_t> free;
+	std::function<void(std::vector<std::size_t>&)> reorder;
+	std::exception_ptr exception;
+	std::atomic<bool> stopping{false};
+	std::size_t current = 0;
+	std::thread producer;
+};
+
+/**
+	Allocates the buffers and starts producing batches of `source`. At the
+	beginning of every epoch, a vector holding the order of tests of the
+	previous epoch, initially `0, 1, ..., source.size() - 1`, is passed to
+	`reorder`, which may permute it. Each epoch is then split into batches
+	of `batchSize` consecutive tests in that order, the last one possibly
+	smaller. `reorder` is called on the producer thread.
+
+	@tparam    Source      A data set type providing `size()`, `inputSize()`,
+	                       `outputSize()`, `input(i)` and `output(i)`, such
+	                       as `DataSet` or `MappedDataSet`
+	@param[in] source      The data set, which must outlive the loader
+	@param[in] batchSize   Number of tests per batch; nonzero
+	@param[in] epochs      Number of epochs to produce
+	@param[in] bufferCount Number of batch buffers; at least 2 are used
+	@param[in] reorder     Function permuting the order of tests
+*/
+template<typename T>
+template<class Source>
+BatchLoader<T>::BatchLoader(const Source& source, std::size_t batchSize, std::size_t epochs, std::size_t bufferCount, std::function<void(std::vector<std::size_t>&)> reorder)
+	: inSize(source.inputSize()), outSize(source.outputSize()), slots(std::max<std::size_t>(bufferCount, 2)),
+	ready(slots.size() + 1), free(slots.size()), reorder(std::move(reorder)) {
+	for (std::size_t i = 0; i < slots.size(); ++i) {
+		slots[i].inputs.resize(batchSize * inSize);
+		slots[i].outputs.resize(batchSize * outSize);
+		free.tryPush(i);
+	}
+	producer = std::thread([this, &source, batchSize, epochs] {
+		produce(source, batchSize, epochs);
+	});
+}
+
+/**
+	Batches that were not consumed are discarded.
+*/
+template<typename T>
+BatchLoader<T>::~BatchLoader() {
+	stopping.store(true, std::memory_order_relaxed);
+	producer.join();
+}
+
+/**
+	The previously acquired batch, if any, must have been released.
+
+	@returns Pointer to the next batch, valid until `release` is called, or
+	         a null pointer once all epochs have been consumed
+
+	@throws Any exception thrown while producing batches
+*/
+template<typename T>
+const typename BatchLoader<T>::Slot* BatchLoader<T>::acquire() {
+	for (std::size_t attempts = 0; !ready.tryPop(current);) {
+		backOff(attempts);
+	}
+	if (current == slots.size()) {
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+		return nullptr;
+	}
+	return &slots[current];
+}
+
+/**
+	The buffer may be overwritten afterwards.
+*/
+template<typename T>
+void BatchLoader<T>::release() {
+	free.tryPush(current);
+}
+
+/**
+	@param[in] slot A batch obtained from `acquire`
+
+	@returns View of the tests of the batch
+*/
+template<typename T>
+typename DataSet<T>::Batch BatchLoader<T>::view(const Slot& slot) const {
+	return typename DataSet<T>::Batch(slot.inputs.data(), slot.outputs.data(), slot.size, inSize, outSize);
+}
+
+template<typename T>
+template<class Source>
+void BatchLoader<T>::produce(const Source& source, std::size_t batchSize, std::size_t epochs) {
+	try {
+		const std::size_t testCount = source.size();
+		std::vector<std::size_t> order(testCount);
+		std::iota(order.begin(), order.end(), std::size_t());
+		for (std::size_t epoch = 0; epoch < epochs && testCount != 0; ++epoch) {
+			reorder(order);
+			for (std::size_t begin = 0; begin < testCount; begin += batchSize) {
+				std::size_t index;
+				for (std::size_t attempts = 0; !free.tryPop(index);) {
+					if (stopping.load(std::memory_order_relaxed)) {
+						return;
+					}
+					backOff(attempts);
+				}
+				Slot& slot = slots[index];
+				slot.size = std::min(batchSize, testCount - begin);
+				slot.lastOfEpoch = begin + slot.size == testCount;
+				for (std::size_t i = 0; i < slot.size; ++i) {
+					std::copy_n(source.input(order[begin + i]), inSize, slot.inputs.data() + i * inSize);
+					std::copy_n(source.output(order[begin + i]), outSize, slot.outputs.data() + i * outSize);
+				}
+				ready.tryPush(index);
+			}
+		}
+	} catch (...) {
+		exception = std::current_exception();
+	}
+	ready.tryPush(slots.size());
+}
+
+template<typename T>
+void BatchLoader<T>::backOff(std::size_t& attempts) {
+	if (++attempts < 64) {
+		std::this_thread::yield();
+	} else {
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+}
+
+}
+
+#endif
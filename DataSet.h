@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef DATA_SET_H_
+#define DATA_SET_H_
+
+#include <algorithm>
+#include <cstddef>
+#include "AlignedAllocator.h"
+
+namespace mlp {
+
+/// Template class representing a set of training tests
+/**
+	A data set stores inputs and expected outputs of all tests in two
+	contiguous, cache-line aligned row-major matrices, where row `i` of
+	each belongs to test `i`. Adding a test therefore performs no per-test
+	allocation, and consecutive tests are adjacent in memory, so that
+	a range of them can be fed to a perceptron as a batch without copying.
+
+	@tparam T Data type of stored values
+*/
+template<typename T>
+class DataSet {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Class representing a range of consecutive tests
+	class Batch {
+	public:
+		/// Constructs the batch from row pointers
+		Batch(const T* inputs, const T* outputs, std::size_t count, std::size_t inputSize, std::size_t outputSize);
+		/// Obtains number of tests
+		std::size_t size() const;
+		/// Obtains the row-major matrix of inputs
+		const T* inputs() const;
+		/// Obtains the row-major matrix of expected outputs
+		const T* outputs() const;
+		/// Obtains input of a test
+		const T* input(std::size_t index) const;
+		/// Obtains expected output of a test
+		const T* output(std::size_t index) const;
+	private:
+		const T* inFirst;
+		const T* outFirst;
+		std::size_t count;
+		std::size_t inSize;
+		std::size_t outSize;
+	};
+	/// Constructs an empty data set
+	DataSet(std::size_t inputSize, std::size_t outputSize);
+	/// Obtains number of tests
+	std::size_t size() const;
+	/// Obtains size of test input
+	std::size_t inputSize() const;
+	/// Obtains size of test output
+	std::size_t outputSize() const;
+	/// Reserves storage for given number of tests
+	void reserve(std::size_t count);
+	/// Removes all tests
+	void clear();
+	/// Adds a new test
+	template<class InputIt1, class InputIt2>
+	void addTest(InputIt1 inFirst, InputIt2 outFirst);
+	/// Adds a number of tests stored in row-major matrices
+	void addTests(const T* inputs, const T* outputs, std::size_t count);
+	/// Obtains input of a test
+	const T* input(std::size_t index) const;
+	/// Obtains expected output of a test
+	const T* output(std::size_t index) const;
+	/// Obtains a view of consecutive tests
+	Batch batch(std::size_t first, std::size_t count) const;
+private:
+	std::size_t inSize;
+	std::size_t outSize;
+	std::size_t testCount = 0;
+	AlignedVector<T> inputData;
+	AlignedVector<T> outputData;
+};
+
+/**
+	@param[in] inputs     The beginning of the first input
+	@param[in] outputs    The beginning of the first expected output
+	@param[in] count      Number of tests
+	@param[in] inputSize  Size of test input
+	@param[in] outputSize Size of test output
+*/
+template<typename T>
+DataSet<T>::Batch::Batch(const T* inputs, const T* outputs, std::size_t count, std::size_t inputSize, std::size_t outputSize)
+	: inFirst(inputs), outFirst(outputs), count(count), inSize(inputSize), outSize(outputSize) {}
+
+/**
+	@returns Number of tests in the batch
+*/
+template<typename T>
+std::size_t DataSet<T>::Batch::size() const {
+	return count;
+}
+
+/**
+	@returns Pointer to the beginning of `size()` consecutive inputs
+*/
+template<typename T>
+const T* DataSet<T>::Batch::inputs() const {
+	return inFirst;
+}
+
+/**
+	@returns Pointer to the beginning of `size()` consecutive expected
+	         outputs
+*/
+template<typename T>
+const T* DataSet<T>::Batch::outputs() const {
+	return outFirst;
+}
+
+/**
+	@param[in] index Index of the test within the batch
+
+	@returns Pointer to the beginning of the input of the test
+*/
+template<typename T>
+const T* DataSet<T>::Batch::input(std::size_t index) const {
+	return inFirst + index * inSize;
+}
+
+/**
+	@param[in] index Index of the test within the batch
+
+	@returns Pointer to the beginning of the expected output of the test
+*/
+template<typename T>
+const T* DataSet<T>::Batch::output(std::size_t index) const {
+	return outFirst + index * outSize;
+}
+
+/**
+	@param[in] inputSize  Size of test input
+	@param[in] outputSize Size of test output
+*/
+template<typename T>
+DataSet<T>::DataSet(std::size_t inputSize, std::size_t outputSize)
+	: inSize(inputSize), outSize(outputSize) {}
+
+/**
+	@returns Number of tests in the data set
+*/
+template<typename T>
+std::size_t DataSet<T>::size() const {
+	return testCount;
+}
+
+/**
+	@returns Size of test input
+*/
+template<typename T>
+std::size_t DataSet<T>::inputSize() const {
+	return inSize;
+}
+
+/**
+	@returns Size of test output
+*/
+template<typename T>
+std::size_t DataSet<T>::outputSize() const {
+	return outSize;
+}
+
+/**
+	Ensures that adding up to `count` tests in total performs no
+	reallocation.
+
+	@param[in] count Number of tests
+*/
+template<typename T>
+void DataSet<T>::reserve(std::size_t count) {
+	inputData.reserve(count * inSize);
+	outputData.reserve(count * outSize);
+}
+
+/**
+	Keeps the allocated storage for reuse.
+*/
+template<typename T>
+void DataSet<T>::clear() {
+	inputData.clear();
+	outputData.clear();
+	testCount = 0;
+}
+
+/**
+	Copies the range `[inFirst, inFirst + inputSize())` as input and the
+	range `[outFirst, outFirst + outputSize())` as expected output of a new
+	test appended to the data set.
+
+	@tparam    InputIt1 Must meet the requirements of `InputIterator`
+	@tparam    InputIt2 Must meet the requirements of `InputIterator`
+	@param[in] inFirst  The beginning of the input range
+	@param[in] outFirst The beginning of the expected output range
+*/
+template<typename T>
+template<class InputIt1, class InputIt2>
+void DataSet<T>::addTest(InputIt1 inFirst, InputIt2 outFirst) {
+	inputData.resize(inputData.size() + inSize);
+	std::copy_n(inFirst, inSize, inputData.end() - inSize);
+	outputData.resize(outputData.size() + outSize);
+	std::copy_n(outFirst, outSize, outputData.end() - outSize);
+	++testCount;
+}
+
+/**
+	Appends `count` tests whose inputs are stored consecutively in the range
+	`[inputs, inputs + count * inputSize())` and whose expected outputs are
+	stored consecutively in the range
+	`[outputs, outputs + count * outputSize())`. Storage grows at most once.
+
+	@param[in] inputs  The beginning of the inputs
+	@param[in] outputs The beginning of the expected outputs
+	@param[in] count   Number of tests
+*/
+template<typename T>
+void DataSet<T>::addTests(const T* inputs, const T* outputs, std::size_t count) {
+	inputData.insert(inputData.end(), inputs, inputs + count * inSize);
+	outputData.insert(outputData.end(), outputs, outputs + count * outSize);
+	testCount += count;
+}
+
+/**
+	@param[in] index Index of the test, which must be less than `size()`
+
+	@returns Pointer to the beginning of the input of the test
+*/
+template<typename T>
+const T* DataSet<T>::input(std::size_t index) const {
+	return inputData.data() + index * inSize;
+}
+
+/**
+	@param[in] index Index of the test, which must be less than `size()`
+
+	@returns Pointer to the beginning of the expected output of the test
+*/
+template<typename T>
+const T* DataSet<T>::output(std::size_t index) const {
+	return outputData.data() + index * outSize;
+}
+
+/**
+	The view refers to the storage of the data set and is invalidated by
+	adding tests. Its inputs may be passed directly to
+	`MultiLayerPerceptron::testBatch`.
+
+	@param[in] first Index of the first test
+	@param[in] count Number of tests; `first + count` must not exceed
+	                 `size()`
+
+	@returns View of tests `[first, first + count)`
+*/
+template<typename T>
+typename DataSet<T>::Batch DataSet<T>::batch(std::size_t first, std::size_t count) const {
+	return Batch(input(first), output(first), count, inSize, outSize);
+}
+
+}
+
+#endif
@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef DATA_SET_FILE_H_
+#define DATA_SET_FILE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "DataSet.h"
+
+namespace mlp {
+
+/// Constants of the binary data set format
+/**
+	A data set file consists of a 64-byte header followed by packed rows,
+	one per test, each holding the test input immediately followed by its
+	expected output. All values are stored in the byte order of the machine
+	that wrote the file, which is recorded in the header.
+
+	The header holds, in order: the magic bytes `MLPD`, the 32-bit format
+	version, the 32-bit byte order mark `0x01020304`, the 32-bit size of
+	the value type in bytes, 4 bytes of zero padding, then the 64-bit input
+	size, output size and number of tests, followed by zero padding. Rows
+	have no padding, so the file size is exactly determined by the header.
+*/
+namespace dataSetFormat {
+
+/// Magic bytes opening every data set file
+constexpr char magic[4] = {'M', 'L', 'P', 'D'};
+/// Version of the format written by `DataSetWriter`
+constexpr std::uint32_t version = 1;
+/// Value stored to identify the byte order
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+/// Size of the header in bytes
+constexpr std::size_t headerSize = 64;
+
+}
+
+/// Template class writing data set files
+/**
+	A data set writer appends tests to a binary data set file one by one,
+	through a buffered stream, so that data sets larger than the available
+	memory can be produced. The number of tests is stored in the header
+	when the writer is closed.
+
+	@tparam T Data type of stored values, `float` or `double`
+*/
+template<typename T>
+class DataSetWriter {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Creates a data set file
+	DataSetWriter(const std::string& path, std::size_t inputSize, std::size_t outputSize);
+	/// Closes the file, ignoring errors
+	~DataSetWriter();
+	/// Obtains number of tests written so far
+	std::size_t size() const;
+	/// Appends a test
+	template<class InputIt1, class InputIt2>
+	void addTest(InputIt1 inFirst, InputIt2 outFirst);
+	/// Completes the header and closes the file
+	void close();
+private:
+	static_assert(std::is_floating_point_v<T>, "data set files store floating point values");
+	void writeHeader();
+	std::ofstream out;
+	std::string path;
+	std::size_t inSize;
+	std::size_t outSize;
+	std::size_t testCount = 0;
+	std::vector<T> row;
+};
+
+/// Writes a data set to a file in the binary data set format
+template<typename T>
+void saveDataSet(const DataSet<T>& dataSet, const std::string& path);
+/// Converts a whitespace-separated text data set to the binary data set format
+template<typename T>
+std::size_t convertTextDataSet(std::istream& in, const std::string& path, std::size_t inputSize, std::size_t outputSize, bool classLabels = false);
+
+/**
+	Creates or truncates the file at `path` and writes a header describing
+	an empty data set.
+
+	@param[in] path       Path to the destination file
+	@param[in] inputSize  Size of test input
+	@param[in] outputSize Size of test output
+
+	@throws std::runtime_error If the file cannot be written
+*/
+template<typename T>
+DataSetWriter<T>::DataSetWriter(const std::string& path, std::size_t inputSize, std::size_t outputSize)
+	: out(path, std::ios::binary | std::ios::trunc), path(path), inSize(inputSize), outSize(outputSize), row(inputSize + outputSize) {
+	if (!out) {
+		throw std::runtime_error("cannot open " + path);
+	}
+	writeHeader();
+}
+
+/**
+	A writer destroyed without calling `close` still completes the header,
+	but errors are not reported.
+*/
+template<typename T>
+DataSetWriter<T>::~DataSetWriter() {
+	try {
+		close();
+	} catch (...) {}
+}
+
+/**
+	@returns Number of tests written so far
+*/
+template<typename T>
+std::size_t DataSetWriter<T>::size() const {
+	return testCount;
+}
+
+/**
+	Appends a test consisting of the input range
+	`[inFirst, inFirst + inputSize)` and the expected output range
+	`[outFirst, outFirst + outputSize)`.
+
+	@tparam    InputIt1 Must meet the requirements of `InputIterator`
+	@tparam    InputIt2 Must meet the requirements of `InputIterator`
+	@param[in] inFirst  The beginning of the input range
+	@param[in] outFirst The beginning of the expected output range
+
+	@throws std::runtime_error If writing fails
+*/
+template<typename T>
+template<class InputIt1, class InputIt2>
+void DataSetWriter<T>::addTest(InputIt1 inFirst, InputIt2 outFirst) {
+	std::copy_n(inFirst, inSize, row.begin());
+	std::copy_n(outFirst, outSize, row.begin() + inSize);
+	if (!out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(T)))) {
+		throw std::runtime_error("cannot write " + path);
+	}
+	++testCount;
+}
+
+/**
+	Does nothing if the file is already closed.
+
+	@throws std::runtime_error If writing fails
+*/
+template<typename T>
+void DataSetWriter<T>::close() {
+	if (!out.is_open()) {
+		return;
+	}
+	out.seekp(0);
+	writeHeader();
+	out.close();
+	if (!out) {
+		throw std::runtime_error("cannot write " + path);
+	}
+}
+
+template<typename T>
+void DataSetWriter<T>::writeHeader() {
+	unsigned char header[dataSetFormat::headerSize] = {};
+	const std::uint32_t version = dataSetFormat::version;
+	const std::uint32_t byteOrderMark = dataSetFormat::byteOrderMark;
+	const std::uint32_t valueSize = sizeof(T);
+	const std::uint64_t sizes[3] = {inSize, outSize, testCount};
+	std::memcpy(header, dataSetFormat::magic, sizeof dataSetFormat::magic);
+	std::memcpy(header + 4, &version, sizeof version);
+	std::memcpy(header + 8, &byteOrderMark, sizeof byteOrderMark);
+	std::memcpy(header + 12, &valueSize, sizeof valueSize);
+	std::memcpy(header + 16, sizes, sizeof sizes);
+	if (!out.write(reinterpret_cast<const char*>(header), sizeof header)) {
+		throw std::runtime_error("cannot write " + path);
+	}
+}
+
+/**
+	@param[in] dataSet The data set to save
+	@param[in] path    Path to the destination file
+
+	@throws std::runtime_error If the file cannot be written
+*/
+template<typename T>
+void saveDataSet(const DataSet<T>& dataSet, const std::string& path) {
+	DataSetWriter<T> writer(path, dataSet.inputSize(), dataSet.outputSize());
+	for (std::size_t i = 0; i < dataSet.size(); ++i) {
+		writer.addTest(dataSet.input(i), dataSet.output(i));
+	}
+	writer.close();
+}
+
+/**
+	Reads tests from `in`, each consisting of `inputSize` whitespace-separated
+	input values followed by either `outputSize` expected output values or,
+	if `classLabels` is `true`, a single class label between 1 and
+	`outputSize`, which is converted to a one-hot expected output. This is
+	the format of the text files used by the example program. Tests are
+	written to the file at `path` as they are read, so the text may be
+	larger than the available memory. Reading stops at the end of the
+	stream or at the first incomplete test.
+
+	@param[in,out] in          The source stream
+	@param[in]     path        Path to the destination file
+	@param[in]     inputSize   Size of test input
+	@param[in]     outputSize  Size of test output
+	@param[in]     classLabels Whether outputs are given as class labels
+
+	@returns Number of converted tests
+
+	@throws std::runtime_error If the file cannot be written or a class
+	                           label is out of range
+*/
+template<typename T>
+std::size_t convertTextDataSet(std::istream& in, const std::string& path, std::size_t inputSize, std::size_t outputSize, bool classLabels) {
+	DataSetWriter<T> writer(path, inputSize, outputSize);
+	std::vector<T> input(inputSize);
+	std::vector<T> output(outputSize);
+	for (;;) {
+		for (T& value : input) {
+			in >> value;
+		}
+		if (classLabels) {
+			std::size_t label = 0;
+			in >> label;
+			if (in && (label < 1 || label > outputSize)) {
+				throw std::runtime_error("class label out of range");
+			}
+			std::fill(output.begin(), output.end(), T());
+			if (in) {
+				output[label - 1] = T(1);
+			}
+		} else {
+			for (T& value : output) {
+				in >> value;
+			}
+		}
+		if (!in) {
+			break;
+		}
+		writer.addTest(input.begin(), output.begin());
+	}
+	writer.close();
+	return writer.size();
+}
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef EPOCH_STATISTICS_H_
+#define EPOCH_STATISTICS_H_
+
+#include <cstddef>
+
+namespace mlp {
+
+/// Structure describing a completed training epoch
+/**
+	Epoch statistics are passed to the callback set by
+	`PerceptronTrainer::setEpochCallback` after every epoch.
+*/
+struct EpochStatistics {
+	/// Number of the epoch, starting from 1
+	std::size_t epoch = 0;
+	/// Average error per test over the epoch
+	double error = 0.0;
+	/// Duration of the epoch in seconds
+	double seconds = 0.0;
+	/// Number of tests trained on per second
+	double samplesPerSecond = 0.0;
+	/// Root mean square of the Euclidean norms of the batch gradients; 0 if not tracked
+	double gradientNorm = 0.0;
+};
+
+}
+
+#endif
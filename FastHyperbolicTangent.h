@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef FAST_HYPERBOLIC_TANGENT_H_
+#define FAST_HYPERBOLIC_TANGENT_H_
+
+#include "ActivationId.h"
+#include "Kernels.h"
+
+namespace mlp {
+
+/// Template class representing an approximated hyperbolic tangent activation function
+/**
+	Activation function @f$ f(x) = \tanh x = 1-\frac{2}{e^{2x}+1} @f$
+	evaluated with `kernels::fastExp`. The absolute error for `float` and
+	`double` is below @f$ 10^{-8} @f$ plus rounding errors. Whole layers are
+	computed by the vectorized `kernels::fastTanh`, which is where the
+	approximation pays off; without AVX2 it is not faster than `std::tanh`.
+
+	@tparam T Must meet the requirements of `NumericType`
+*/
+template<typename T>
+class FastHyperbolicTangent {
+public:
+	/// Identifier of the function
+	constexpr static ActivationId id = ActivationId::fastHyperbolicTangent;
+	/// Returns approximate hyperbolic tangent value
+	static T f(T x);
+	/// Returns approximate hyperbolic tangent derivative value
+	static T df(T x);
+	/// Returns hyperbolic tangent derivative value expressed by function value
+	constexpr static T dfy(T y);
+};
+
+/**
+	@param[in] x Function argument
+
+	@returns Approximate function value @f$ f(x) = \tanh{x} @f$
+*/
+template<typename T>
+T FastHyperbolicTangent<T>::f(T x) {
+	return T(1) - T(2) / (kernels::fastExp(T(2) * x) + T(1));
+}
+
+/**
+	@param[in] x Derivative argument
+
+	@returns Approximate derivative value @f$ f^\prime(x) = 1-f^2(x) @f$
+*/
+template<typename T>
+T FastHyperbolicTangent<T>::df(T x) {
+	return dfy(f(x));
+}
+
+/**
+	@param[in] y Function value @f$ y = f(x) @f$
+
+	@returns Derivative value @f$ f^\prime(x) = 1-y^2 @f$
+*/
+template<typename T>
+constexpr T FastHyperbolicTangent<T>::dfy(T y) {
+	return T(1) - y * y;
+}
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef FAST_LOGISTIC_FUNCTION_H_
+#define FAST_LOGISTIC_FUNCTION_H_
+
+#include "ActivationId.h"
+#include "Kernels.h"
+
+namespace mlp {
+
+/// Template class representing an approximated sigmoid activation function
+/**
+	Activation function @f$ f(x) = \frac{1}{1+e^{-x}} @f$ evaluated with
+	`kernels::fastExp`, whose relative error for `float` and `double` is
+	below @f$ 10^{-8} @f$ plus rounding errors. Whole layers are computed
+	by the vectorized `kernels::fastLogistic`, which is where the
+	approximation pays off; without AVX2 it is not faster than `std::exp`.
+
+	@tparam T Must meet the requirements of `NumericType`
+*/
+template<typename T>
+class FastLogisticFunction {
+public:
+	/// Identifier of the function
+	constexpr static ActivationId id = ActivationId::fastLogistic;
+	/// Returns approximate logistic function value
+	static T f(T x);
+	/// Returns approximate logistic function derivative value
+	static T df(T x);
+	/// Returns logistic function derivative value expressed by function value
+	constexpr static T dfy(T y);
+};
+
+/**
+	@param[in] x Function argument
+
+	@returns Approximate function value @f$ f(x) = \frac{1}{1+e^{-x}} @f$
+*/
+template<typename T>
+T FastLogisticFunction<T>::f(T x) {
+	return T(1) / (T(1) + kernels::fastExp(-x));
+}
+
+/**
+	@param[in] x Derivative argument
+
+	@returns Approximate derivative value @f$ f^\prime(x) = f(x)(1-f(x)) @f$
+*/
+template<typename T>
+T FastLogisticFunction<T>::df(T x) {
+	return dfy(f(x));
+}
+
+/**
+	@param[in] y Function value @f$ y = f(x) @f$
+
+	@returns Derivative value @f$ f^\prime(x) = y(1-y) @f$
+*/
+template<typename T>
+constexpr T FastLogisticFunction<T>::dfy(T y) {
+	return y * (T(1) - y);
+}
+
+}
+
+#endif
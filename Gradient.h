@@ -0,0 +1,175 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef GRADIENT_H_
+#define GRADIENT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "Kernels.h"
+
+namespace mlp {
+
+/// Template class representing changes to all weights and biases of a perceptron
+/**
+	A gradient stores changes to weights and biases of every layer of
+	a perceptron in a single contiguous buffer, laid out layer by layer as
+	the row-major weight matrix followed by the bias vector. It allows
+	changes to be accumulated outside of the perceptron, e.g. by several
+	threads at once, and merged later.
+
+	@tparam T Must meet the requirements of `NumericType`
+*/
+template<typename T>
+class Gradient {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Constructs an empty gradient
+	Gradient() = default;
+	/// Constructs a zero gradient matching the shape of a perceptron
+	template<class Perceptron>
+	explicit Gradient(const Perceptron& perceptron);
+	/// Obtains number of layers
+	std::size_t size() const;
+	/// Obtains changes to weights of a layer
+	T* weights(std::size_t layer);
+	/// Obtains changes to weights of a layer
+	const T* weights(std::size_t layer) const;
+	/// Obtains changes to biases of a layer
+	T* biases(std::size_t layer);
+	/// Obtains changes to biases of a layer
+	const T* biases(std::size_t layer) const;
+	/// Resets all changes to zero
+	void clear();
+	/// Adds changes stored in another gradient of the same shape
+	Gradient& operator+=(const Gradient& other);
+	/// Computes the squared Euclidean norm of all changes
+	T squaredNorm() const;
+private:
+	AlignedVector<T> values;
+	std::vector<std::size_t> offsets;
+};
+
+/**
+	@tparam    Perceptron A perceptron type providing `size()` and
+	                      `layer(i)`, such as `MultiLayerPerceptron`
+	@param[in] perceptron The perceptron whose shape to match
+*/
+template<typename T>
+template<class Perceptron>
+Gradient<T>::Gradient(const Perceptron& perceptron) {
+	std::size_t offset = 0;
+	offsets.reserve(2 * perceptron.size() + 1);
+	for (std::size_t i = 0; i < perceptron.size(); ++i) {
+		const auto& group = perceptron.layer(i).group;
+		offsets.push_back(offset);
+		offset += group.size() * group.inputSize();
+		offsets.push_back(offset);
+		offset += group.size();
+	}
+	offsets.push_back(offset);
+	values.resize(offset);
+}
+
+/**
+	@returns Number of layers of the matched perceptron
+*/
+template<typename T>
+std::size_t Gradient<T>::size() const {
+	return offsets.empty() ? 0 : offsets.size() / 2;
+}
+
+/**
+	@param[in] layer Index of the layer
+
+	@returns Pointer to the beginning of the row-major weight change matrix
+*/
+template<typename T>
+T* Gradient<T>::weights(std::size_t layer) {
+	return values.data() + offsets[2 * layer];
+}
+
+/**
+	@param[in] layer Index of the layer
+
+	@returns Pointer to the beginning of the row-major weight change matrix
+*/
+template<typename T>
+const T* Gradient<T>::weights(std::size_t layer) const {
+	return values.data() + offsets[2 * layer];
+}
+
+/**
+	@param[in] layer Index of the layer
+
+	@returns Pointer to the beginning of the bias change vector
+*/
+template<typename T>
+T* Gradient<T>::biases(std::size_t layer) {
+	return values.data() + offsets[2 * layer + 1];
+}
+
+/**
+	@param[in] layer Index of the layer
+
+	@returns Pointer to the beginning of the bias change vector
+*/
+template<typename T>
+const T* Gradient<T>::biases(std::size_t layer) const {
+	return values.data() + offsets[2 * layer + 1];
+}
+
+/**
+	Sets all stored changes to zero, retaining the shape.
+*/
+template<typename T>
+void Gradient<T>::clear() {
+	std::fill(values.begin(), values.end(), T());
+}
+
+/**
+	@param[in] other A gradient of the same shape
+
+	@returns `*this`
+*/
+template<typename T>
+Gradient<T>& Gradient<T>::operator+=(const Gradient& other) {
+	kernels::axpy(T(1), other.values.data(), values.data(), values.size());
+	return *this;
+}
+
+/**
+	@returns Sum of squares of changes to all weights and biases
+*/
+template<typename T>
+T Gradient<T>::squaredNorm() const {
+	return kernels::dot(values.data(), values.data(), values.size());
+}
+
+}
+
+#endif
@@ -0,0 +1,412 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef HEADER_GENERATOR_H_
+#define HEADER_GENERATOR_H_
+
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <locale>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "ActivationId.h"
+#include "MultiLayerPerceptron.h"
+
+namespace mlp {
+
+/// Writes a standalone C++ header computing the output of a perceptron
+template<typename T, typename A>
+void generateHeader(const MultiLayerPerceptron<T, A>& perceptron, const std::string& name, std::ostream& out);
+/// Writes a standalone C++ header computing the output of a perceptron to a file
+template<typename T, typename A>
+void generateHeader(const MultiLayerPerceptron<T, A>& perceptron, const std::string& name, const std::string& path);
+
+/// Helpers of the header generator
+namespace headerGenerator {
+
+/// Largest number of weights of a layer whose computation is unrolled
+constexpr std::size_t maxUnrolledWeights = 4096;
+
+/// Checks whether a string is a valid C++ identifier that is neither a keyword nor reserved
+bool isIdentifier(const std::string& name);
+/// Derives the include guard of a header from its namespace name
+std::string includeGuard(const std::string& name);
+/// Writes a floating point value as a literal that reads back exactly
+template<typename T>
+void writeLiteral(std::ostream& out, T value);
+/// Writes definitions of the activation functions used by a perceptron
+void writeActivations(std::ostream& out, const bool (&used)[8]);
+/// Obtains name of the generated function computing an activation function
+const char* activationName(ActivationId id);
+
+/**
+	Rejects keywords, including alternative operator tokens and keywords
+	introduced after C++17, and names reserved to the implementation: those
+	starting with an underscore, which are reserved in the global namespace,
+	and those containing a double underscore.
+
+	@param[in] name The string to check
+
+	@returns Whether `name` is a non-empty sequence of letters, digits and
+	         underscores not starting with a digit or an underscore, not
+	         containing a double underscore and not being a keyword
+*/
+inline bool isIdentifier(const std::string& name) {
+	static const char* const keywords[] = {
+		"alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break",
+		"case", "catch", "char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept",
+		"const", "consteval", "constexpr", "constinit", "const_cast", "continue", "co_await",
+		"co_return", "co_yield", "decltype", "default", "delete", "do", "double", "dynamic_cast",
+		"else", "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto",
+		"if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+		"nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register",
+		"reinterpret_cast", "requires", "return", "short", "signed", "sizeof", "static",
+		"static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local",
+		"throw", "true", "try", "typedef", "typeid", "typename", "union", "unsigned", "using",
+		"virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq",
+	};
+	if (name.empty() || std::isdigit(static_cast<unsigned char>(name.front())) || name.front() == '_' || name.find("__") != std::string::npos) {
+		return false;
+	}
+	for (char c : name) {
+		if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+			return false;
+		}
+	}
+	for (const char* keyword : keywords) {
+		if (name == keyword) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+	Splits `name` into words at lowercase-to-uppercase transitions, joins
+	them with underscores and converts them to uppercase, as in the include
+	guards of this library.
+
+	@param[in] name A valid identifier
+
+	@returns The include guard, e.g. `IRIS_CLASSIFIER_H_` for
+	         `irisClassifier`
+*/
+inline std::string includeGuard(const std::string& name) {
+	std::string result;
+	for (std::size_t i = 0; i < name.size(); ++i) {
+		const unsigned char c = static_cast<unsigned char>(name[i]);
+		if (i > 0 && std::isupper(c) && !std::isupper(static_cast<unsigned char>(name[i - 1])) && name[i - 1] != '_') {
+			result += '_';
+		}
+		result += static_cast<char>(std::toupper(c));
+	}
+	return result + "_H_";
+}
+
+/**
+	Uses as many significant digits as needed to distinguish any two values
+	of type `T`, and appends the `f` suffix to `float` literals.
+
+	@param[out] out   The destination stream
+	@param[in]  value A finite value
+
+	@throws std::invalid_argument If `value` is not finite
+*/
+template<typename T>
+void writeLiteral(std::ostream& out, T value) {
+	if (!std::isfinite(value)) {
+		throw std::invalid_argument("perceptron has non-finite weights");
+	}
+	std::ostringstream literal;
+	literal.imbue(std::locale::classic());
+	literal.precision(std::numeric_limits<T>::max_digits10);
+	literal << std::scientific << value;
+	out << literal.str() << (std::is_same_v<T, float> ? "f" : "");
+}
+
+/**
+	@param[in] id Identifier of a built-in activation function
+
+	@returns Name of the function in the generated header
+*/
+inline const char* activationName(ActivationId id) {
+	switch (id) {
+	case ActivationId::identity:
+		return "identity";
+	case ActivationId::logistic:
+		return "logistic";
+	case ActivationId::hyperbolicTangent:
+		return "hyperbolicTangent";
+	case ActivationId::rectifier:
+		return "rectifier";
+	case ActivationId::fastLogistic:
+		return "fastLogistic";
+	case ActivationId::fastHyperbolicTangent:
+		return "fastHyperbolicTangent";
+	case ActivationId::softmax:
+		return "softmax";
+	default:
+		return "custom";
+	}
+}
+
+/**
+	Writes an inline function of the generated `ValueType` for every
+	activation function marked as used, matching the corresponding class of
+	this library. The fast functions share a copy of `kernels::fastExp`.
+
+	@param[out] out  The destination stream
+	@param[in]  used Flags indexed by `ActivationId`
+*/
+inline void writeActivations(std::ostream& out, const bool (&used)[8]) {
+	const auto isUsed = [&](ActivationId id) {
+		return used[static_cast<std::size_t>(id)];
+	};
+	if (isUsed(ActivationId::identity)) {
+		out << "inline ValueType identity(ValueType x) {\n\treturn x;\n}\n\n";
+	}
+	if (isUsed(ActivationId::logistic)) {
+		out << "inline ValueType logistic(ValueType x) {\n\treturn ValueType(1) / (ValueType(1) + std::exp(-x));\n}\n\n";
+	}
+	if (isUsed(ActivationId::hyperbolicTangent)) {
+		out << "inline ValueType hyperbolicTangent(ValueType x) {\n\treturn std::tanh(x);\n}\n\n";
+	}
+	if (isUsed(ActivationId::rectifier)) {
+		out << "inline ValueType rectifier(ValueType x) {\n\treturn x > ValueType() ? x : ValueType();\n}\n\n";
+	}
+	if (isUsed(ActivationId::fastLogistic) || isUsed(ActivationId::fastHyperbolicTangent)) {
+		out << "inline ValueType fastExp(ValueType x) {\n"
+			"\tusing Bits = std::conditional_t<std::is_same_v<ValueType, float>, std::int32_t, std::int64_t>;\n"
+			"\tconstexpr bool single = std::is_same_v<ValueType, float>;\n"
+			"\tconstexpr ValueType ln2High = single ? ValueType(0.693359375) : ValueType(6.93145751953125e-1);\n"
+			"\tconstexpr ValueType ln2Low = single ? ValueType(-2.12194440e-4) : ValueType(1.42860682030941723212e-6);\n"
+			"\tx = std::min(std::max(x, single ? ValueType(-87) : ValueType(-708)), single ? ValueType(88) : ValueType(709));\n"
+			"\tconst Bits k = static_cast<Bits>(x * ValueType(1.44269504088896341) + (x < ValueType() ? ValueType(-0.5) : ValueType(0.5)));\n"
+			"\tconst ValueType n = ValueType(k);\n"
+			"\tconst ValueType r = x - n * ln2High - n * ln2Low;\n"
+			"\tValueType p = ValueType(1) / 5040;\n"
+			"\tp = p * r + ValueType(1) / 720;\n"
+			"\tp = p * r + ValueType(1) / 120;\n"
+			"\tp = p * r + ValueType(1) / 24;\n"
+			"\tp = p * r + ValueType(1) / 6;\n"
+			"\tp = p * r + ValueType(0.5);\n"
+			"\tp = p * r + ValueType(1);\n"
+			"\tp = p * r + ValueType(1);\n"
+			"\tconst Bits bits = (k + std::numeric_limits<ValueType>::max_exponent - 1) << (std::numeric_limits<ValueType>::digits - 1);\n"
+			"\tValueType scale;\n"
+			"\tstd::memcpy(&scale, &bits, sizeof scale);\n"
+			"\treturn p * scale;\n"
+			"}\n\n";
+	}
+	if (isUsed(ActivationId::fastLogistic)) {
+		out << "inline ValueType fastLogistic(ValueType x) {\n\treturn ValueType(1) / (ValueType(1) + fastExp(-x));\n}\n\n";
+	}
+	if (isUsed(ActivationId::fastHyperbolicTangent)) {
+		out << "inline ValueType fastHyperbolicTangent(ValueType x) {\n\treturn ValueType(1) - ValueType(2) / (fastExp(ValueType(2) * x) + ValueType(1));\n}\n\n";
+	}
+	if (isUsed(ActivationId::softmax)) {
+		out << "inline void softmax(ValueType* x, std::size_t count) {\n"
+			"\tValueType max = x[0];\n"
+			"\tfor (std::size_t i = 1; i < count; ++i) {\n"
+			"\t\tmax = std::max(max, x[i]);\n"
+			"\t}\n"
+			"\tValueType sum = ValueType();\n"
+			"\tfor (std::size_t i = 0; i < count; ++i) {\n"
+			"\t\tx[i] = std::exp(x[i] - max);\n"
+			"\t\tsum += x[i];\n"
+			"\t}\n"
+			"\tconst ValueType scale = ValueType(1) / sum;\n"
+			"\tfor (std::size_t i = 0; i < count; ++i) {\n"
+			"\t\tx[i] *= scale;\n"
+			"\t}\n"
+			"}\n\n";
+	}
+}
+
+}
+
+/**
+	Writes a self-contained header defining namespace `name`, which holds
+	the value type `ValueType`, the constants `inputSize` and `outputSize`,
+	and the function `void infer(const ValueType* input, ValueType* output)`
+	computing the output of `perceptron`. The header depends only on the
+	standard library. Weights and biases become `constexpr` arrays, so
+	a program including the header needs no model file and no
+	initialization, and the compiler may propagate the weights as
+	constants.
+
+	Each layer with at most `headerGenerator::maxUnrolledWeights` weights
+	is written as one statement per neuron; larger layers are written as
+	loops with constant bounds. Activation functions are emitted inline,
+	including the approximations of the fast functions, so the generated
+	function matches `MultiLayerPerceptron::test` up to rounding.
+
+	@param[in]  perceptron The perceptron to export
+	@param[in]  name       Name of the generated namespace, which must be
+	                       a valid identifier as checked by
+	                       `headerGenerator::isIdentifier`; the include
+	                       guard is derived from it
+	@param[out] out        The destination stream
+
+	@throws std::invalid_argument If `name` is not a valid identifier, the
+	                              perceptron has no layers, any layer uses
+	                              a custom activation function or any weight
+	                              is not finite
+	@throws std::runtime_error    If writing fails
+*/
+template<typename T, typename A>
+void generateHeader(const MultiLayerPerceptron<T, A>& perceptron, const std::string& name, std::ostream& out) {
+	using namespace headerGenerator;
+	static_assert(std::is_floating_point_v<T>, "generated headers use floating point values");
+	if (!isIdentifier(name)) {
+		throw std::invalid_argument("header name is not a valid identifier");
+	}
+	if (perceptron.size() == 0) {
+		throw std::invalid_argument("perceptron has no layers");
+	}
+	bool used[8] = {};
+	std::string topology = std::to_string(perceptron.inputSize()), activations;
+	for (std::size_t i = 0; i < perceptron.size(); ++i) {
+		const auto& layer = perceptron.layer(i);
+		const ActivationId id = layer.activation.id();
+		if (id == ActivationId::custom || id > ActivationId::softmax) {
+			throw std::invalid_argument("custom activation functions cannot be exported");
+		}
+		used[static_cast<std::size_t>(id)] = true;
+		topology += "-" + std::to_string(layer.group.size());
+		activations += (i == 0 ? "" : ", ") + std::string(activationName(id));
+	}
+	std::ostringstream text;
+	text << "// Generated by mlp::generateHeader; do not edit.\n";
+	text << "// Topology: " << topology << "\n";
+	text << "// Activation functions: " << activations << "\n\n";
+	text << "#ifndef " << includeGuard(name) << "\n#define " << includeGuard(name) << "\n\n";
+	text << "#include <algorithm>\n#include <cmath>\n#include <cstddef>\n";
+	if (used[static_cast<std::size_t>(ActivationId::fastLogistic)] || used[static_cast<std::size_t>(ActivationId::fastHyperbolicTangent)]) {
+		text << "#include <cstdint>\n#include <cstring>\n#include <limits>\n#include <type_traits>\n";
+	}
+	text << "\nnamespace " << name << " {\n\n";
+	text << "/// Value type of the network\nusing ValueType = " << (std::is_same_v<T, float> ? "float" : "double") << ";\n";
+	text << "/// Size of network input\nconstexpr std::size_t inputSize = " << perceptron.inputSize() << ";\n";
+	text << "/// Size of network output\nconstexpr std::size_t outputSize = " << perceptron.outputSize() << ";\n\n";
+	text << "namespace detail {\n\n";
+	for (std::size_t i = 0; i < perceptron.size(); ++i) {
+		const auto& group = perceptron.layer(i).group;
+		const T* weights = group.weightData();
+		text << "constexpr ValueType weights" << i << "[" << group.size() << "][" << group.inputSize() << "] = {\n";
+		for (std::size_t r = 0; r < group.size(); ++r) {
+			text << "\t{";
+			for (std::size_t c = 0; c < group.inputSize(); ++c) {
+				text << (c == 0 ? "" : ", ");
+				writeLiteral(text, weights[r * group.inputSize() + c]);
+			}
+			text << "},\n";
+		}
+		text << "};\n\nconstexpr ValueType biases" << i << "[" << group.size() << "] = {";
+		for (std::size_t r = 0; r < group.size(); ++r) {
+			text << (r % 4 == 0 ? "\n\t" : " ");
+			writeLiteral(text, group.biasData()[r]);
+			text << ",";
+		}
+		text << "\n};\n\n";
+	}
+	writeActivations(text, used);
+	text << "}\n\n";
+	text << "/// Computes the output of the network for one input\n";
+	text << "inline void infer(const ValueType* input, ValueType* output) {\n";
+	std::string source = "input";
+	for (std::size_t i = 0; i < perceptron.size(); ++i) {
+		const auto& layer = perceptron.layer(i);
+		const std::size_t rows = layer.group.size(), cols = layer.group.inputSize();
+		const ActivationId id = layer.activation.id();
+		const bool last = i + 1 == perceptron.size();
+		const std::string target = last ? "output" : "layer" + std::to_string(i);
+		const std::string w = "detail::weights" + std::to_string(i), b = "detail::biases" + std::to_string(i);
+		const std::string f = id == ActivationId::softmax ? "" : std::string("detail::") + activationName(id);
+		if (!last) {
+			text << "\tValueType " << target << "[" << rows << "];\n";
+		}
+		if (rows * cols <= maxUnrolledWeights) {
+			for (std::size_t r = 0; r < rows; ++r) {
+				text << "\t" << target << "[" << r << "] = " << f << "(" << b << "[" << r << "]";
+				for (std::size_t c = 0; c < cols; ++c) {
+					text << " + " << w << "[" << r << "][" << c << "] * " << source << "[" << c << "]";
+				}
+				text << ");\n";
+			}
+		} else {
+			text << "\tfor (std::size_t i = 0; i < " << rows << "; ++i) {\n";
+			text << "\t\tValueType sum = " << b << "[i];\n";
+			text << "\t\tfor (std::size_t j = 0; j < " << cols << "; ++j) {\n";
+			text << "\t\t\tsum += " << w << "[i][j] * " << source << "[j];\n";
+			text << "\t\t}\n";
+			text << "\t\t" << target << "[i] = " << f << "(sum);\n";
+			text << "\t}\n";
+		}
+		if (id == ActivationId::softmax) {
+			text << "\tdetail::softmax(" << target << ", " << rows << ");\n";
+		}
+		source = target;
+	}
+	text << "}\n\n}\n\n#endif\n";
+	const std::string result = text.str();
+	if (!out.write(result.data(), static_cast<std::streamsize>(result.size()))) {
+		throw std::runtime_error("cannot write header");
+	}
+}
+
+/**
+	Creates or truncates the file at `path` and writes the header to it as
+	by the stream overload.
+
+	@param[in] perceptron The perceptron to export
+	@param[in] name       Name of the generated namespace
+	@param[in] path       Path to the destination file
+
+	@throws std::invalid_argument As by the stream overload
+	@throws std::runtime_error    If the file cannot be written
+*/
+template<typename T, typename A>
+void generateHeader(const MultiLayerPerceptron<T, A>& perceptron, const std::string& name, const std::string& path) {
+	std::ofstream out(path, std::ios::trunc);
+	if (!out) {
+		throw std::runtime_error("cannot open " + path);
+	}
+	generateHeader(perceptron, name, out);
+	out.close();
+	if (!out) {
+		throw std::runtime_error("cannot write " + path);
+	}
+}
+
+}
+
+#endif
@@ -26,7 +26,7 @@
 #define HYPERBOLIC_TANGENT_H_
 
 #include <cmath>
-#include "ActivationFunction.h"
+#include "ActivationId.h"
 
 namespace mlp {
 
@@ -41,10 +41,14 @@ namespace mlp {
 template<typename T>
 class HyperbolicTangent {
 public:
+	/// Identifier of the function
+	constexpr static ActivationId id = ActivationId::hyperbolicTangent;
 	/// Returns hyperbolic tangent value
 	constexpr static T f(T x);
 	/// Returns hyperbolic tangent derivative value
 	constexpr static T df(T x);
+	/// Returns hyperbolic tangent derivative value expressed by function value
+	constexpr static T dfy(T y);
 };
 
 /**
@@ -64,8 +68,17 @@ constexpr T HyperbolicTangent<T>::f(T x) {
 */
 template<typename T>
 constexpr T HyperbolicTangent<T>::df(T x) {
-	T t = std::tanh(x);
-	return T(1) - t * t;
+	return dfy(f(x));
+}
+
+/**
+	@param[in] y Function value @f$ y = f(x) @f$
+
+	@returns Derivative value @f$ f^\prime(x) = 1-y^2 @f$
+*/
+template<typename T>
+constexpr T HyperbolicTangent<T>::dfy(T y) {
+	return T(1) - y * y;
 }
 
 }
@@ -25,7 +25,7 @@
 #ifndef IDENTITY_FUNCTION_H_
 #define IDENTITY_FUNCTION_H_
 
-#include "ActivationFunction.h"
+#include "ActivationId.h"
 
 namespace mlp {
 
@@ -38,10 +38,14 @@ namespace mlp {
 template<typename T>
 class IdentityFunction {
 public:
+	/// Identifier of the function
+	constexpr static ActivationId id = ActivationId::identity;
 	/// Returns its argument
 	constexpr static T f(T x);
 	/// Returns 1
 	constexpr static T df(T);
+	/// Returns 1
+	constexpr static T dfy(T);
 };
 
 /**
@@ -62,6 +66,14 @@ constexpr T IdentityFunction<T>::df(T) {
 	return T(1);
 }
 
+/**
+	@returns Derivative value @f$ f^\prime(x) = 1 @f$
+*/
+template<typename T>
+constexpr T IdentityFunction<T>::dfy(T) {
+	return T(1);
+}
+
 }
 
 #endif
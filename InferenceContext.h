@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef INFERENCE_CONTEXT_H_
+#define INFERENCE_CONTEXT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include "AlignedAllocator.h"
+
+namespace mlp {
+
+/// Template class holding scratch buffers for perceptron inference
+/**
+	An inference context owns a pair of ping-pong activation buffers, each
+	able to hold `capacity` samples of `width` values. A perceptron reads
+	a layer's input from one buffer and writes its output to the other,
+	then swaps them. Reusing a context across calls avoids allocating
+	intermediate results on every call. A context may only be used by one
+	call at a time, so concurrent inference needs one context per thread.
+
+	@tparam T Data type of stored values
+*/
+template<typename T>
+class InferenceContext {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Constructs an empty context
+	InferenceContext() = default;
+	/// Constructs the context for given buffer dimensions
+	InferenceContext(std::size_t width, std::size_t capacity = 1);
+	/// Obtains number of values per sample the buffers can hold
+	std::size_t width() const;
+	/// Obtains number of samples the buffers can hold
+	std::size_t capacity() const;
+	/// Ensures the buffers can hold at least given number of samples
+	void reserve(std::size_t width, std::size_t capacity);
+	/// Obtains the buffer to be written to
+	T* front();
+	/// Obtains the buffer to be read from
+	T* back();
+	/// Exchanges the buffers
+	void swap();
+private:
+	std::size_t bufferWidth = 0;
+	std::size_t bufferCapacity = 0;
+	AlignedVector<T> frontBuffer;
+	AlignedVector<T> backBuffer;
+};
+
+/**
+	@param[in] width    Number of values per sample
+	@param[in] capacity Number of samples
+*/
+template<typename T>
+InferenceContext<T>::InferenceContext(std::size_t width, std::size_t capacity) {
+	reserve(width, capacity);
+}
+
+/**
+	@returns Number of values per sample the buffers can hold
+*/
+template<typename T>
+std::size_t InferenceContext<T>::width() const {
+	return bufferWidth;
+}
+
+/**
+	@returns Number of samples the buffers can hold
+*/
+template<typename T>
+std::size_t InferenceContext<T>::capacity() const {
+	return bufferCapacity;
+}
+
+/**
+	Grows the buffers if either dimension exceeds the current one. Never
+	shrinks the buffers, so that repeated calls with the same arguments
+	perform no allocations. Contents of the buffers are unspecified
+	afterwards.
+
+	@param[in] width    Number of values per sample
+	@param[in] capacity Number of samples
+*/
+template<typename T>
+void InferenceContext<T>::reserve(std::size_t width, std::size_t capacity) {
+	if (width > bufferWidth || capacity > bufferCapacity) {
+		bufferWidth = std::max(width, bufferWidth);
+		bufferCapacity = std::max(capacity, bufferCapacity);
+		frontBuffer.resize(bufferWidth * bufferCapacity);
+		backBuffer.resize(bufferWidth * bufferCapacity);
+	}
+}
+
+/**
+	@returns Pointer to the beginning of the buffer to be written to
+*/
+template<typename T>
+T* InferenceContext<T>::front() {
+	return frontBuffer.data();
+}
+
+/**
+	@returns Pointer to the beginning of the buffer to be read from
+*/
+template<typename T>
+T* InferenceContext<T>::back() {
+	return backBuffer.data();
+}
+
+/**
+	Exchanges the buffers, so that the most recently written buffer
+	becomes the one to be read from.
+*/
+template<typename T>
+void InferenceContext<T>::swap() {
+	std::swap(frontBuffer, backBuffer);
+}
+
+}
+
+#endif
@@ -0,0 +1,799 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "SimdKernels.h"
+
+namespace mlp {
+
+/// Numeric kernels operating on contiguous arrays
+/**
+	The kernels are the hot paths of both inference and training. They
+	operate on raw contiguous ranges so that the compiler is free to
+	vectorize them. The kernels below additionally dispatch at run time,
+	according to `simdLevel()`, to hand-vectorized implementations from
+	the given level up to AVX-512. The columns stand for `float` or
+	`double` operands, `float` values with `double` accumulators, and
+	8-bit integers; other combinations run the portable code.
+
+	Kernel                                          | Floating | Mixed | Integer
+	----------------------------------------------- | -------- | ----- | -------
+	`dot`                                           | SSE2     | -     | SSE2
+	`axpy`, `momentumUpdate`                        | SSE2     | AVX2  | -
+	`nesterovUpdate`, `rmsPropUpdate`, `adamUpdate` | AVX2     | AVX2  | -
+	`gemmTile`                                      | AVX2     | -     | SSE2
+	`quantize`, `fastLogistic`, `fastTanh`          | AVX2     | -     | -
+
+	Results of different implementations may differ in the last bits.
+*/
+namespace kernels {
+
+/// Computes the dot product of two arrays
+template<typename T>
+T dot(const T* x, const T* y, std::size_t n);
+
+/// Computes the dot product of two arrays of 8-bit integers
+std::int32_t dot(const std::int8_t* x, const std::int8_t* y, std::size_t n);
+
+/// Converts values to 8-bit integers in a given scale
+template<typename T, typename Q>
+void quantize(const T* x, std::size_t n, T scale, Q* q);
+
+/// Adds a scaled array to another array
+template<typename T, typename U = T>
+void axpy(U a, const T* x, U* y, std::size_t n);
+
+/// Adds scaled differences to values and decays the differences
+template<typename T, typename U = T>
+void momentumUpdate(U rate, U momentum, T* values, U* diffs, std::size_t n);
+
+/// Applies changes by the Nesterov momentum rule and clears them
+template<typename T, typename U = T>
+void nesterovUpdate(U rate, U momentum, T* values, U* changes, U* velocities, std::size_t n);
+
+/// Applies changes by the RMSProp rule and clears them
+template<typename T, typename U = T>
+void rmsPropUpdate(U rate, U decay, U epsilon, T* values, U* changes, U* squares, std::size_t n);
+
+/// Applies changes by the Adam rule and clears them
+template<typename T, typename U = T>
+void adamUpdate(U rate, U decay1, U decay2, U epsilon, T* values, U* changes, U* moments, U* squares, std::size_t n);
+
+/// Multiplies a row-major matrix by a vector and adds a bias vector
+template<typename T>
+void gemv(const T* matrix, const T* bias, const T* x, std::size_t rows, std::size_t cols, T* y);
+
+/// Computes a tile of the product of input rows and a packed matrix panel
+template<typename T>
+void gemmTile(const T* panel, const T* in, std::size_t stride, std::size_t depth, T* acc);
+
+/// Multiplies a batch of row vectors by a transposed matrix and adds a bias vector
+template<typename T>
+void gemm(const T* x, std::size_t count, const T* matrix, const T* bias, std::size_t rows, std::size_t cols, T* y);
+
+/// Obtains size of an 8-bit integer matrix packed by `packPanels`
+constexpr std::size_t packedSize(std::size_t rows, std::size_t cols);
+
+/// Packs a row-major 8-bit integer matrix into panels of eight rows
+void packPanels(const std::int8_t* matrix, std::size_t rows, std::size_t cols, std::int8_t* panels);
+
+/// Computes a tile of the product of integer input rows and a packed 8-bit panel
+void gemmTile(const std::int8_t* panel, const std::int16_t* in, std::size_t stride, std::size_t depth, std::size_t count, std::int32_t* acc);
+
+/// Multiplies a batch of integer row vectors by a packed 8-bit matrix and scales the products
+template<typename T>
+void gemm(const std::int16_t* x, std::size_t count, const std::int8_t* panels, const T* scales, const T* bias, std::size_t rows, std::size_t cols, T* y);
+
+/// Computes an approximation of the exponential function
+template<typename T>
+T fastExp(T x);
+
+/// Computes approximate logistic function values of an array
+template<typename T>
+void fastLogistic(const T* x, std::size_t n, T* y);
+
+/// Computes approximate hyperbolic tangent values of an array
+template<typename T>
+void fastTanh(const T* x, std::size_t n, T* y);
+
+/**
+	The sum is split across four independent accumulators, which removes the
+	loop-carried dependency of a sequential sum and lets the loop vectorize.
+	Consequently, the result may differ from `std::inner_product` in the
+	last bits.
+
+	@param[in] x The beginning of the first array
+	@param[in] y The beginning of the second array
+	@param[in] n Number of elements of each array
+
+	@returns @f$ \sum_i x_i y_i @f$
+*/
+template<typename T>
+T dot(const T* x, const T* y, std::size_t n) {
+#ifdef MLP_SIMD
+	if constexpr (isVectorizable<T>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			return avx512::dot(x, y, n);
+		case SimdLevel::avx2:
+			return avx2::dot(x, y, n);
+		case SimdLevel::sse2:
+			return sse2::dot(x, y, n);
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	T s0 = T(), s1 = T(), s2 = T(), s3 = T();
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		s0 += x[i] * y[i];
+		s1 += x[i + 1] * y[i + 1];
+		s2 += x[i + 2] * y[i + 2];
+		s3 += x[i + 3] * y[i + 3];
+	}
+	for (; i < n; ++i) {
+		s0 += x[i] * y[i];
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+/**
+	Products are summed in 32-bit integers. For values produced by
+	`quantize`, the result is exact as long as @f$ n \le 2^{17} @f$ .
+
+	@param[in] x The beginning of the first array
+	@param[in] y The beginning of the second array
+	@param[in] n Number of elements of each array
+
+	@returns @f$ \sum_i x_i y_i @f$
+*/
+inline std::int32_t dot(const std::int8_t* x, const std::int8_t* y, std::size_t n) {
+#ifdef MLP_SIMD
+	switch (simdLevel()) {
+	case SimdLevel::avx512:
+		return avx512::dot(x, y, n);
+	case SimdLevel::avx2:
+		return avx2::dot(x, y, n);
+	case SimdLevel::sse2:
+		return sse2::dot(x, y, n);
+	case SimdLevel::none:
+		break;
+	}
+#endif
+	std::int32_t result = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		result += std::int32_t(x[i]) * y[i];
+	}
+	return result;
+}
+
+/**
+	Computes @f$ q_i = \mathrm{round}(x_i / scale) @f$ , saturated to the
+	symmetric range @f$ [-127, 127] @f$ . Ties are rounded away from zero.
+	The result may be stored in 16-bit integers, which `gemm` on packed
+	8-bit matrices takes as input. `q` may point to the storage of `x`,
+	because every value is read before the bytes at its index are written.
+
+	@tparam     Q     `std::int8_t` or `std::int16_t`
+	@param[in]  x     The beginning of the array to convert
+	@param[in]  n     Number of elements of each array
+	@param[in]  scale Value represented by a unit of the result; positive
+	@param[out] q     The beginning of the destination array
+*/
+template<typename T, typename Q>
+void quantize(const T* x, std::size_t n, T scale, Q* q) {
+#ifdef MLP_SIMD
+	if constexpr (isVectorizable<T>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::quantize(x, n, scale, q);
+			return;
+		case SimdLevel::avx2:
+			avx2::quantize(x, n, scale, q);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	const T inverse = T(1) / scale;
+	for (std::size_t i = 0; i < n; ++i) {
+		const T v = std::min(std::max(x[i] * inverse, T(-127)), T(127));
+		q[i] = static_cast<Q>(v < T() ? v - T(0.5) : v + T(0.5));
+	}
+}
+
+/**
+	Computes @f$ y \leftarrow y + ax @f$ . The destination may have a wider
+	type than the scaled array, e.g. to accumulate `float` values in
+	`double` precision; each element of `x` is then converted to `U` before
+	the multiplication.
+
+	@param[in]     a Scaling factor
+	@param[in]     x The beginning of the scaled array
+	@param[in,out] y The beginning of the destination array
+	@param[in]     n Number of elements of each array
+*/
+template<typename T, typename U>
+void axpy(U a, const T* x, U* y, std::size_t n) {
+#ifdef MLP_SIMD
+	if constexpr (std::is_same_v<T, float> && std::is_same_v<U, double>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::axpy(a, x, y, n);
+			return;
+		case SimdLevel::avx2:
+			avx2::axpy(a, x, y, n);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	} else if constexpr (std::is_same_v<T, U> && isVectorizable<T>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::axpy(a, x, y, n);
+			return;
+		case SimdLevel::avx2:
+			avx2::axpy(a, x, y, n);
+			return;
+		case SimdLevel::sse2:
+			sse2::axpy(a, x, y, n);
+			return;
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	for (std::size_t i = 0; i < n; ++i) {
+		y[i] += a * U(x[i]);
+	}
+}
+
+/**
+	Computes @f$ v \leftarrow v + \eta d @f$ followed by
+	@f$ d \leftarrow \mu d @f$ in a single pass over both arrays. The
+	differences may have a wider type than the values, in which case each
+	step is computed in the wider type and rounded to `T`.
+
+	@param[in]     rate     Learning rate @f$ \eta @f$
+	@param[in]     momentum Momentum @f$ \mu @f$
+	@param[in,out] values   The beginning of the value array
+	@param[in,out] diffs    The beginning of the difference array
+	@param[in]     n        Number of elements of each array
+*/
+template<typename T, typename U>
+void momentumUpdate(U rate, U momentum, T* values, U* diffs, std::size_t n) {
+#ifdef MLP_SIMD
+	if constexpr (std::is_same_v<T, float> && std::is_same_v<U, double>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::momentumUpdate(rate, momentum, values, diffs, n);
+			return;
+		case SimdLevel::avx2:
+			avx2::momentumUpdate(rate, momentum, values, diffs, n);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	} else if constexpr (std::is_same_v<T, U> && isVectorizable<T>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::momentumUpdate(rate, momentum, values, diffs, n);
+			return;
+		case SimdLevel::avx2:
+			avx2::momentumUpdate(rate, momentum, values, diffs, n);
+			return;
+		case SimdLevel::sse2:
+			sse2::momentumUpdate(rate, momentum, values, diffs, n);
+			return;
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	for (std::size_t i = 0; i < n; ++i) {
+		values[i] = T(values[i] + diffs[i] * rate);
+		diffs[i] *= momentum;
+	}
+}
+
+/**
+	Computes @f$ u \leftarrow \mu u + g @f$ and
+	@f$ v \leftarrow v + \eta (g + \mu u) @f$ , where @f$ g @f$ are the
+	changes, which are then set to zero, all in a single pass over the
+	arrays. As for `momentumUpdate`, the changes and velocities may have
+	a wider type than the values.
+
+	@param[in]     rate       Learning rate @f$ \eta @f$
+	@param[in]     momentum   Momentum @f$ \mu @f$
+	@param[in,out] values     The beginning of the value array
+	@param[in,out] changes    The beginning of the change array
+	@param[in,out] velocities The beginning of the velocity array @f$ u @f$
+	@param[in]     n          Number of elements of each array
+*/
+template<typename T, typename U>
+void nesterovUpdate(U rate, U momentum, T* values, U* changes, U* velocities, std::size_t n) {
+#ifdef MLP_SIMD
+	if constexpr ((std::is_same_v<T, U> && isVectorizable<T>) || (std::is_same_v<T, float> && std::is_same_v<U, double>)) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::nesterovUpdate(rate, momentum, values, changes, velocities, n);
+			return;
+		case SimdLevel::avx2:
+			avx2::nesterovUpdate(rate, momentum, values, changes, velocities, n);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	for (std::size_t i = 0; i < n; ++i) {
+		const U g = changes[i];
+		velocities[i] = momentum * velocities[i] + g;
+		values[i] = T(values[i] + rate * (g + momentum * velocities[i]));
+		changes[i] = U();
+	}
+}
+
+/**
+	Computes @f$ s \leftarrow \rho s + (1 - \rho) g^2 @f$ and
+	@f$ v \leftarrow v + \eta \frac{g}{\sqrt{s} + \epsilon} @f$ ,
+	where @f$ g @f$ are the changes, which are then set to zero, all in
+	a single pass over the arrays.
+
+	@param[in]     rate    Learning rate @f$ \eta @f$
+	@param[in]     decay   Decay rate @f$ \rho @f$ of the mean square
+	@param[in]     epsilon Term @f$ \epsilon @f$ guarding against division by zero
+	@param[in,out] values  The beginning of the value array
+	@param[in,out] changes The beginning of the change array
+	@param[in,out] squares The beginning of the mean square array @f$ s @f$
+	@param[in]     n       Number of elements of each array
+*/
+template<typename T, typename U>
+void rmsPropUpdate(U rate, U decay, U epsilon, T* values, U* changes, U* squares, std::size_t n) {
+#ifdef MLP_SIMD
+	if constexpr ((std::is_same_v<T, U> && isVectorizable<T>) || (std::is_same_v<T, float> && std::is_same_v<U, double>)) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::rmsPropUpdate(rate, decay, epsilon, values, changes, squares, n);
+			return;
+		case SimdLevel::avx2:
+			avx2::rmsPropUpdate(rate, decay, epsilon, values, changes, squares, n);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	for (std::size_t i = 0; i < n; ++i) {
+		const U g = changes[i];
+		squares[i] = decay * squares[i] + (1 - decay) * (g * g);
+		values[i] = T(values[i] + rate * (g / (std::sqrt(squares[i]) + epsilon)));
+		changes[i] = U();
+	}
+}
+
+/**
+	Computes @f$ m \leftarrow \beta_1 m + (1 - \beta_1) g @f$ ,
+	@f$ s \leftarrow \beta_2 s + (1 - \beta_2) g^2 @f$ and
+	@f$ v \leftarrow v + \eta \frac{m}{\sqrt{s} + \epsilon} @f$ ,
+	where @f$ g @f$ are the changes, which are then set to zero, all in
+	a single pass over the arrays. Bias correction of the moments is left
+	to the caller, which may fold it into @f$ \eta @f$ and
+	@f$ \epsilon @f$ .
+
+	@param[in]     rate    Learning rate @f$ \eta @f$
+	@param[in]     decay1  Decay rate @f$ \beta_1 @f$ of the mean
+	@param[in]     decay2  Decay rate @f$ \beta_2 @f$ of the mean square
+	@param[in]     epsilon Term @f$ \epsilon @f$ guarding against division by zero
+	@param[in,out] values  The beginning of the value array
+	@param[in,out] changes The beginning of the change array
+	@param[in,out] moments The beginning of the mean array @f$ m @f$
+	@param[in,out] squares The beginning of the mean square array @f$ s @f$
+	@param[in]     n       Number of elements of each array
+*/
+template<typename T, typename U>
+void adamUpdate(U rate, U decay1, U decay2, U epsilon, T* values, U* changes, U* moments, U* squares, std::size_t n) {
+#ifdef MLP_SIMD
+	if constexpr ((std::is_same_v<T, U> && isVectorizable<T>) || (std::is_same_v<T, float> && std::is_same_v<U, double>)) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::adamUpdate(rate, decay1, decay2, epsilon, values, changes, moments, squares, n);
+			return;
+		case SimdLevel::avx2:
+			avx2::adamUpdate(rate, decay1, decay2, epsilon, values, changes, moments, squares, n);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	for (std::size_t i = 0; i < n; ++i) {
+		const U g = changes[i];
+		moments[i] = decay1 * moments[i] + (1 - decay1) * g;
+		squares[i] = decay2 * squares[i] + (1 - decay2) * (g * g);
+		values[i] = T(values[i] + rate * (moments[i] / (std::sqrt(squares[i]) + epsilon)));
+		changes[i] = U();
+	}
+}
+
+/**
+	Computes @f$ y \leftarrow Wx + b @f$ .
+
+	@param[in]  matrix The beginning of the row-major matrix @f$ W @f$
+	@param[in]  bias   The beginning of the bias vector @f$ b @f$
+	@param[in]  x      The beginning of the input vector
+	@param[in]  rows   Number of rows of the matrix
+	@param[in]  cols   Number of columns of the matrix
+	@param[out] y      The beginning of the output vector
+*/
+template<typename T>
+void gemv(const T* matrix, const T* bias, const T* x, std::size_t rows, std::size_t cols, T* y) {
+	for (std::size_t i = 0; i < rows; ++i) {
+		y[i] = bias[i] + dot(matrix + i * cols, x, cols);
+	}
+}
+
+/**
+	Computes a 4x8 tile of the product of four input rows, `stride` elements
+	apart, and the transpose of a panel of eight matrix rows packed column
+	by column, i.e. @f$ acc_{cr} = \sum_k in_{c,k} \, panel_{k,r} @f$ .
+
+	@param[in]  panel  The beginning of the packed panel of `depth` columns
+	@param[in]  in     The beginning of the first input row
+	@param[in]  stride Distance between consecutive input rows
+	@param[in]  depth  Number of columns to process
+	@param[out] acc    The beginning of the row-major 4x8 result tile
+*/
+template<typename T>
+void gemmTile(const T* panel, const T* in, std::size_t stride, std::size_t depth, T* acc) {
+#ifdef MLP_SIMD
+	if constexpr (isVectorizable<T>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::gemmTile(panel, in, stride, depth, acc);
+			return;
+		case SimdLevel::avx2:
+			avx2::gemmTile(panel, in, stride, depth, acc);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	std::fill_n(acc, 32, T());
+	for (std::size_t k = 0; k < depth; ++k) {
+		for (std::size_t c = 0; c < 4; ++c) {
+			const T v = in[c * stride + k];
+			for (std::size_t r = 0; r < 8; ++r) {
+				acc[c * 8 + r] += v * panel[k * 8 + r];
+			}
+		}
+	}
+}
+
+/**
+	Computes @f$ Y \leftarrow XW^T + \mathbf{1}b^T @f$ , i.e. applies `gemv`
+	to each of `count` consecutive rows of `x`. The computation is blocked:
+	a panel of eight matrix rows and up to 256 columns is packed column by
+	column into a local buffer that stays in the L1 cache, and tiles of
+	four inputs by eight outputs are computed by `gemmTile` while the
+	panel is traversed.
+
+	@param[in]  x      The beginning of the row-major input matrix @f$ X @f$
+	                   of `count` rows and `cols` columns
+	@param[in]  count  Number of input rows
+	@param[in]  matrix The beginning of the row-major matrix @f$ W @f$
+	@param[in]  bias   The beginning of the bias vector @f$ b @f$
+	@param[in]  rows   Number of rows of the matrix
+	@param[in]  cols   Number of columns of the matrix
+	@param[out] y      The beginning of the row-major output matrix of
+	                   `count` rows and `rows` columns
+*/
+template<typename T>
+void gemm(const T* x, std::size_t count, const T* matrix, const T* bias, std::size_t rows, std::size_t cols, T* y) {
+	constexpr std::size_t panelRows = 8;
+	constexpr std::size_t tileCount = 4;
+	constexpr std::size_t depthBlock = 256;
+	alignas(64) T panel[depthBlock * panelRows];
+	alignas(64) T acc[tileCount * panelRows];
+	for (std::size_t s = 0; s < count; ++s) {
+		std::copy_n(bias, rows, y + s * rows);
+	}
+	for (std::size_t i0 = 0; i0 < rows; i0 += panelRows) {
+		const std::size_t m = std::min(panelRows, rows - i0);
+		for (std::size_t k0 = 0; k0 < cols; k0 += depthBlock) {
+			const std::size_t depth = std::min(depthBlock, cols - k0);
+			for (std::size_t k = 0; k < depth; ++k) {
+				for (std::size_t r = 0; r < panelRows; ++r) {
+					panel[k * panelRows + r] = r < m ? matrix[(i0 + r) * cols + k0 + k] : T();
+				}
+			}
+			std::size_t s = 0;
+			for (; s + tileCount <= count; s += tileCount) {
+				gemmTile(panel, x + s * cols + k0, cols, depth, acc);
+				for (std::size_t c = 0; c < tileCount; ++c) {
+					for (std::size_t r = 0; r < m; ++r) {
+						y[(s + c) * rows + i0 + r] += acc[c * panelRows + r];
+					}
+				}
+			}
+			for (; s < count; ++s) {
+				const T* in = x + s * cols + k0;
+				for (std::size_t r = 0; r < m; ++r) {
+					T sum = T();
+					for (std::size_t k = 0; k < depth; ++k) {
+						sum += in[k] * panel[k * panelRows + r];
+					}
+					y[s * rows + i0 + r] += sum;
+				}
+			}
+		}
+	}
+}
+
+/**
+	@param[in] rows Number of rows of the matrix
+	@param[in] cols Number of columns of the matrix
+
+	@returns Number of bytes of the packed matrix, which is padded to
+	         a whole number of panels and an even number of columns
+*/
+constexpr std::size_t packedSize(std::size_t rows, std::size_t cols) {
+	return (rows + 7) / 8 * ((cols + 1) / 2) * 16;
+}
+
+/**
+	Stores every panel of eight consecutive rows as a sequence of pairs of
+	columns, each holding the two weights of every row next to each other,
+	so that `gemmTile` multiplies a pair of inputs by a pair of columns of
+	all eight rows with a single multiply-add of 16-bit integers. Missing
+	rows and the missing column of an odd number of columns are zero.
+
+	@param[in]  matrix The beginning of the row-major matrix
+	@param[in]  rows   Number of rows of the matrix
+	@param[in]  cols   Number of columns of the matrix
+	@param[out] panels The beginning of the destination of
+	                   `packedSize(rows, cols)` bytes
+*/
+inline void packPanels(const std::int8_t* matrix, std::size_t rows, std::size_t cols, std::int8_t* panels) {
+	const std::size_t pairs = (cols + 1) / 2;
+	for (std::size_t i0 = 0; i0 < rows; i0 += 8) {
+		std::int8_t* panel = panels + i0 / 8 * pairs * 16;
+		for (std::size_t j = 0; j < pairs; ++j) {
+			for (std::size_t r = 0; r < 8; ++r) {
+				for (std::size_t h = 0; h < 2; ++h) {
+					const std::size_t k = 2 * j + h;
+					panel[16 * j + 2 * r + h] = i0 + r < rows && k < cols ? matrix[(i0 + r) * cols + k] : std::int8_t();
+				}
+			}
+		}
+	}
+}
+
+/**
+	Computes a tile of the product of up to four integer input rows,
+	`stride` elements apart, and the transpose of a panel packed by
+	`packPanels`, i.e. @f$ acc_{cr} = \sum_k in_{c,k} \, panel_{r,k} @f$ .
+	The sums are exact for inputs produced by `quantize`.
+
+	@param[in]  panel  The beginning of the packed panel
+	@param[in]  in     The beginning of the first input row
+	@param[in]  stride Distance between consecutive input rows
+	@param[in]  depth  Number of columns of the panel and of every input row
+	@param[in]  count  Number of input rows, at most 4
+	@param[out] acc    The beginning of the row-major `count`x8 result tile
+*/
+inline void gemmTile(const std::int8_t* panel, const std::int16_t* in, std::size_t stride, std::size_t depth, std::size_t count, std::int32_t* acc) {
+#ifdef MLP_SIMD
+	switch (simdLevel()) {
+	case SimdLevel::avx512:
+		avx512::gemmTile(panel, in, stride, depth, count, acc);
+		return;
+	case SimdLevel::avx2:
+		avx2::gemmTile(panel, in, stride, depth, count, acc);
+		return;
+	case SimdLevel::sse2:
+		sse2::gemmTile(panel, in, stride, depth, count, acc);
+		return;
+	case SimdLevel::none:
+		break;
+	}
+#endif
+	std::fill_n(acc, count * 8, std::int32_t());
+	for (std::size_t k = 0; k < depth; ++k) {
+		for (std::size_t c = 0; c < count; ++c) {
+			const std::int32_t v = in[c * stride + k];
+			for (std::size_t r = 0; r < 8; ++r) {
+				acc[c * 8 + r] += v * panel[k / 2 * 16 + 2 * r + k % 2];
+			}
+		}
+	}
+}
+
+/**
+	Computes @f$ y_{sr} = b_r + d_r \sum_k x_{s,k} W_{r,k} @f$ for a matrix
+	@f$ W @f$ of 8-bit integers packed by `packPanels`. The weights are
+	packed once, so unlike `gemm` on floating point values, no panel is
+	copied during the call, and the integer sums are computed by `gemmTile`
+	in tiles of four inputs by eight outputs, which also serves single
+	inputs without any horizontal reductions.
+
+	@param[in]  x      The beginning of the row-major input matrix of
+	                   `count` rows and `cols` columns
+	@param[in]  count  Number of input rows
+	@param[in]  panels The beginning of the packed matrix @f$ W @f$
+	@param[in]  scales The beginning of the scale vector @f$ d @f$
+	@param[in]  bias   The beginning of the bias vector @f$ b @f$
+	@param[in]  rows   Number of rows of the matrix
+	@param[in]  cols   Number of columns of the matrix
+	@param[out] y      The beginning of the row-major output matrix of
+	                   `count` rows and `rows` columns
+*/
+template<typename T>
+void gemm(const std::int16_t* x, std::size_t count, const std::int8_t* panels, const T* scales, const T* bias, std::size_t rows, std::size_t cols, T* y) {
+	constexpr std::size_t panelRows = 8;
+	constexpr std::size_t tileCount = 4;
+	const std::size_t panelSize = packedSize(panelRows, cols);
+	alignas(64) std::int32_t acc[tileCount * panelRows];
+	for (std::size_t i0 = 0; i0 < rows; i0 += panelRows) {
+		const std::size_t m = std::min(panelRows, rows - i0);
+		const std::int8_t* panel = panels + i0 / panelRows * panelSize;
+		for (std::size_t s = 0; s < count; s += tileCount) {
+			const std::size_t n = std::min(tileCount, count - s);
+			gemmTile(panel, x + s * cols, cols, cols, n, acc);
+			for (std::size_t c = 0; c < n; ++c) {
+				for (std::size_t r = 0; r < m; ++r) {
+					y[(s + c) * rows + i0 + r] = bias[i0 + r] + scales[i0 + r] * T(acc[c * panelRows + r]);
+				}
+			}
+		}
+	}
+}
+
+/**
+	For `float` and `double`, the argument is reduced to
+	@f$ x = n \ln 2 + r @f$ with @f$ |r| \le \frac{\ln 2}{2} @f$ , and
+	@f$ e^r @f$ is evaluated by its Taylor polynomial of degree 7, so that
+	the relative error stays below @f$ 10^{-8} @f$ plus rounding errors.
+	Arguments are clamped to the range in which the result is a normal
+	number, hence very small results are never rounded to zero and very
+	large ones never overflow. For other types, `std::exp` is used.
+
+	@param[in] x Function argument
+
+	@returns Approximation of @f$ e^x @f$
+*/
+template<typename T>
+T fastExp(T x) {
+	if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+		using Bits = std::conditional_t<std::is_same_v<T, float>, std::int32_t, std::int64_t>;
+		constexpr bool single = std::is_same_v<T, float>;
+		constexpr T ln2High = single ? T(0.693359375) : T(6.93145751953125e-1);
+		constexpr T ln2Low = single ? T(-2.12194440e-4) : T(1.42860682030941723212e-6);
+		x = std::min(std::max(x, single ? T(-87) : T(-708)), single ? T(88) : T(709));
+		const Bits k = static_cast<Bits>(x * T(1.44269504088896341) + (x < T() ? T(-0.5) : T(0.5)));
+		const T n = T(k);
+		const T r = x - n * ln2High - n * ln2Low;
+		T p = T(1) / 5040;
+		p = p * r + T(1) / 720;
+		p = p * r + T(1) / 120;
+		p = p * r + T(1) / 24;
+		p = p * r + T(1) / 6;
+		p = p * r + T(0.5);
+		p = p * r + T(1);
+		p = p * r + T(1);
+		const Bits bits = (k + std::numeric_limits<T>::max_exponent - 1) << (std::numeric_limits<T>::digits - 1);
+		T scale;
+		std::memcpy(&scale, &bits, sizeof scale);
+		return p * scale;
+	} else {
+		return std::exp(x);
+	}
+}
+
+/**
+	Computes @f$ y_i = \frac{1}{1+e^{-x_i}} @f$ using `fastExp`. The
+	arrays may be equal but must not otherwise overlap.
+
+	@param[in]  x The beginning of the argument array
+	@param[in]  n Number of elements of each array
+	@param[out] y The beginning of the destination array
+*/
+template<typename T>
+void fastLogistic(const T* x, std::size_t n, T* y) {
+#ifdef MLP_SIMD
+	if constexpr (isVectorizable<T>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::fastLogistic(x, n, y);
+			return;
+		case SimdLevel::avx2:
+			avx2::fastLogistic(x, n, y);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	for (std::size_t i = 0; i < n; ++i) {
+		y[i] = T(1) / (T(1) + fastExp(-x[i]));
+	}
+}
+
+/**
+	Computes @f$ y_i = 1-\frac{2}{e^{2x_i}+1} = \tanh x_i @f$ using
+	`fastExp`. The absolute error is bounded by that of `fastExp`, but the
+	relative error grows for arguments close to zero. The arrays may be
+	equal but must not otherwise overlap.
+
+	@param[in]  x The beginning of the argument array
+	@param[in]  n Number of elements of each array
+	@param[out] y The beginning of the destination array
+*/
+template<typename T>
+void fastTanh(const T* x, std::size_t n, T* y) {
+#ifdef MLP_SIMD
+	if constexpr (isVectorizable<T>) {
+		switch (simdLevel()) {
+		case SimdLevel::avx512:
+			avx512::fastTanh(x, n, y);
+			return;
+		case SimdLevel::avx2:
+			avx2::fastTanh(x, n, y);
+			return;
+		case SimdLevel::sse2:
+		case SimdLevel::none:
+			break;
+		}
+	}
+#endif
+	for (std::size_t i = 0; i < n; ++i) {
+		y[i] = T(1) - T(2) / (fastExp(T(2) * x[i]) + T(1));
+	}
+}
+
+}
+
+}
+
+#endif
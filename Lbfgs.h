@@ -0,0 +1,271 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef LBFGS_H_
+#define LBFGS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "Kernels.h"
+
+namespace mlp {
+
+/// Methods of minimizing the training error
+enum class TrainingMethod : unsigned char {
+	/// Batched first-order descent with an `Optimizer`
+	gradientDescent,
+	/// Full-batch limited-memory BFGS with a backtracking line search
+	lbfgs,
+};
+
+/// Template class computing limited-memory BFGS search directions for a perceptron
+/**
+	The solver treats all weights and biases of a perceptron as a single
+	parameter vector, laid out like a `Gradient`, and the changes memorized
+	by the perceptron over the whole data set as the negative gradient of
+	the summed loss, halved for `LossId::squaredError`. It keeps a bounded
+	history of parameter steps and gradient differences and combines them
+	by the two-loop recursion into an approximation of the inverse Hessian
+	applied to the gradient.
+
+	A training step calls `search` once, after the error and changes at the
+	current parameters have been computed, and then `move` for every trial
+	step of the line search, computing the error and changes anew after
+	each move. The next `search` takes the last trial as the accepted point.
+
+	@tparam A Type in which changes are accumulated and the solver computes
+*/
+template<typename A>
+class Lbfgs {
+public:
+	/// Data type the class operates on
+	using ValueType = A;
+	/// Constructs the solver for perceptrons of the shape of a perceptron
+	template<class Perceptron>
+	Lbfgs(const Perceptron& perceptron, std::size_t historySize);
+	/// Obtains number of stored correction pairs
+	std::size_t size() const;
+	/// Takes the current weights and biases of a perceptron as the starting point
+	template<class Perceptron>
+	void reset(Perceptron& perceptron);
+	/// Computes a search direction from the current state of a perceptron
+	template<class Perceptron>
+	A search(Perceptron& perceptron);
+	/// Sets weights and biases of a perceptron to a point along the search direction
+	template<class Perceptron>
+	void move(Perceptron& perceptron, A step);
+private:
+	template<class Perceptron, class Function>
+	static void forEach(Perceptron& perceptron, Function function);
+	A* pair(AlignedVector<A>& history, std::size_t index);
+	std::size_t capacity;
+	std::size_t count = 0;
+	std::size_t next = 0;
+	bool started = false;
+	AlignedVector<A> origin;
+	AlignedVector<A> gradient;
+	AlignedVector<A> direction;
+	AlignedVector<A> steps;
+	AlignedVector<A> differences;
+	std::vector<A> inverseCurvatures;
+	std::vector<A> coefficients;
+};
+
+/**
+	@tparam    Perceptron  A perceptron type providing `size()` and
+	                       `layer(i)`, such as `MultiLayerPerceptron`
+	@param[in] perceptron  The perceptron whose shape to match
+	@param[in] historySize Maximum number of stored correction pairs; at
+	                       least one is kept
+*/
+template<typename A>
+template<class Perceptron>
+Lbfgs<A>::Lbfgs(const Perceptron& perceptron, std::size_t historySize)
+	: capacity(std::max(historySize, std::size_t(1))), inverseCurvatures(capacity), coefficients(capacity) {
+	std::size_t parameters = 0;
+	for (std::size_t i = 0; i < perceptron.size(); ++i) {
+		const auto& group = perceptron.layer(i).group;
+		parameters += group.size() * group.inputSize() + group.size();
+	}
+	origin.resize(parameters);
+	gradient.resize(parameters);
+	direction.resize(parameters);
+	steps.resize(capacity * parameters);
+	differences.resize(capacity * parameters);
+}
+
+/**
+	@returns Number of correction pairs the next search direction is
+	         computed from
+*/
+template<typename A>
+std::size_t Lbfgs<A>::size() const {
+	return count;
+}
+
+/**
+	Discards the stored correction pairs and the changes memorized by
+	`perceptron`, and takes its weights and biases as the point the next
+	search starts from. Must be called before the error and changes at
+	that point are computed.
+
+	@param[in,out] perceptron The perceptron the solver was constructed for
+*/
+template<typename A>
+template<class Perceptron>
+void Lbfgs<A>::reset(Perceptron& perceptron) {
+	forEach(perceptron, [&](auto* values, A* changes, std::size_t offset, std::size_t n) {
+		for (std::size_t i = 0; i < n; ++i) {
+			origin[offset + i] = A(values[i]);
+			changes[i] = A();
+		}
+	});
+	count = 0;
+	next = 0;
+	started = false;
+}
+
+/**
+	Reads the weights, biases and memorized changes of `perceptron`,
+	clearing the changes. Unless this is the first search since a reset,
+	the difference from the previous search is stored as a correction pair,
+	provided that its curvature is positive. The new search direction is
+	then computed, falling back to steepest descent if the approximation
+	does not yield a descent direction.
+
+	@param[in,out] perceptron The perceptron the solver was constructed for
+
+	@returns Directional derivative of the summed loss, or of half of it
+	         for squared error, along the search direction, which is
+	         negative unless the gradient is zero
+*/
+template<typename A>
+template<class Perceptron>
+A Lbfgs<A>::search(Perceptron& perceptron) {
+	A* s = pair(steps, next);
+	A* y = pair(differences, next);
+	forEach(perceptron, [&](auto* values, A* changes, std::size_t offset, std::size_t n) {
+		for (std::size_t i = offset; i < offset + n; ++i) {
+			const A x = A(values[i - offset]);
+			const A g = -changes[i - offset];
+			changes[i - offset] = A();
+			s[i] = x - origin[i];
+			y[i] = g - gradient[i];
+			origin[i] = x;
+			gradient[i] = g;
+		}
+	});
+	const std::size_t parameters = origin.size();
+	if (started) {
+		const A curvature = kernels::dot(s, y, parameters);
+		if (curvature > std::numeric_limits<A>::epsilon() * kernels::dot(y, y, parameters)) {
+			inverseCurvatures[next] = 1 / curvature;
+			next = (next + 1) % capacity;
+			count = std::min(count + 1, capacity);
+		} else if (count == capacity) {
+			--count;
+		}
+	}
+	started = true;
+	const A gradientNorm = std::sqrt(kernels::dot(gradient.data(), gradient.data(), parameters));
+	std::copy(gradient.begin(), gradient.end(), direction.begin());
+	for (std::size_t k = 0; k < count; ++k) {
+		const std::size_t index = (next + capacity - 1 - k) % capacity;
+		coefficients[index] = inverseCurvatures[index] * kernels::dot(pair(steps, index), direction.data(), parameters);
+		kernels::axpy(-coefficients[index], pair(differences, index), direction.data(), parameters);
+	}
+	A scale = gradientNorm > A() ? 1 / gradientNorm : A(1);
+	if (count > 0) {
+		const std::size_t newest = (next + capacity - 1) % capacity;
+		const A* v = pair(differences, newest);
+		scale = 1 / (inverseCurvatures[newest] * kernels::dot(v, v, parameters));
+	}
+	for (auto& value : direction) {
+		value *= -scale;
+	}
+	for (std::size_t k = count; k--;) {
+		const std::size_t index = (next + capacity - 1 - k) % capacity;
+		const A beta = inverseCurvatures[index] * kernels::dot(pair(differences, index), direction.data(), parameters);
+		kernels::axpy(-coefficients[index] - beta, pair(steps, index), direction.data(), parameters);
+	}
+	A slope = kernels::dot(gradient.data(), direction.data(), parameters);
+	if (!(slope < A()) && gradientNorm > A()) {
+		count = 0;
+		for (std::size_t i = 0; i < parameters; ++i) {
+			direction[i] = -gradient[i] / gradientNorm;
+		}
+		slope = -gradientNorm;
+	}
+	return slope;
+}
+
+/**
+	Sets the weights and biases of `perceptron` to the point of the last
+	search moved by `step` along the search direction, and discards the
+	changes memorized by it. A step of 0 restores the point of the last
+	search.
+
+	@param[in,out] perceptron The perceptron the solver was constructed for
+	@param[in]     step       Length of the step relative to the search
+	                          direction
+*/
+template<typename A>
+template<class Perceptron>
+void Lbfgs<A>::move(Perceptron& perceptron, A step) {
+	forEach(perceptron, [&](auto* values, A* changes, std::size_t offset, std::size_t n) {
+		using T = std::remove_reference_t<decltype(*values)>;
+		for (std::size_t i = 0; i < n; ++i) {
+			values[i] = T(origin[offset + i] + step * direction[offset + i]);
+			changes[i] = A();
+		}
+	});
+}
+
+template<typename A>
+template<class Perceptron, class Function>
+void Lbfgs<A>::forEach(Perceptron& perceptron, Function function) {
+	std::size_t offset = 0;
+	for (std::size_t i = 0; i < perceptron.size(); ++i) {
+		auto& group = perceptron.layer(i).group;
+		const std::size_t weightCount = group.size() * group.inputSize();
+		function(group.weightData(), group.weightChangeData(), offset, weightCount);
+		offset += weightCount;
+		function(group.biasData(), group.biasChangeData(), offset, group.size());
+		offset += group.size();
+	}
+}
+
+template<typename A>
+A* Lbfgs<A>::pair(AlignedVector<A>& history, std::size_t index) {
+	return history.data() + index * origin.size();
+}
+
+}
+
+#endif
@@ -26,7 +26,7 @@
 #define LOGISTIC_FUNCTION_H_
 
 #include <cmath>
-#include "ActivationFunction.h"
+#include "ActivationId.h"
 
 namespace mlp {
 
@@ -40,10 +40,14 @@ namespace mlp {
 template<typename T>
 class LogisticFunction {
 public:
+	/// Identifier of the function
+	constexpr static ActivationId id = ActivationId::logistic;
 	/// Returns logistic function value
 	constexpr static T f(T x);
 	/// Returns logistic function derivative value
 	constexpr static T df(T x);
+	/// Returns logistic function derivative value expressed by function value
+	constexpr static T dfy(T y);
 };
 
 /**
@@ -59,13 +63,21 @@ constexpr T LogisticFunction<T>::f(T x) {
 /**
 	@param[in] x Derivative argument
 
-	@returns Derivative value @f$ f^\prime(x) = \frac{e^x}{(1+e^x)^2} @f$
+	@returns Derivative value @f$ f^\prime(x) = f(x)(1-f(x)) @f$
 */
 template<typename T>
 constexpr T LogisticFunction<T>::df(T x) {
-	double e = std::exp(x);
-	double e1 = e + T(1);
-	return e / (e1 * e1);
+	return dfy(f(x));
+}
+
+/**
+	@param[in] y Function value @f$ y = f(x) @f$
+
+	@returns Derivative value @f$ f^\prime(x) = y(1-y) @f$
+*/
+template<typename T>
+constexpr T LogisticFunction<T>::dfy(T y) {
+	return y * (T(1) - y);
 }
 
 }
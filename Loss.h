@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef LOSS_H_
+#define LOSS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include "ActivationId.h"
+
+namespace mlp {
+
+/// Identifiers of loss functions minimized by training
+/**
+	The loss of a perceptron is selected by `MultiLayerPerceptron::setLoss`
+	and determines both the error reported by training and the factors
+	backpropagation starts from.
+*/
+enum class LossId : unsigned char {
+	/// Sum of squared differences between the output and the expected output
+	squaredError = 0,
+	/// Cross-entropy of the output relative to the expected output
+	crossEntropy = 1,
+};
+
+/// Checks whether a loss function may be used with an output activation function
+constexpr bool isCompatible(LossId loss, ActivationId activation);
+
+/// Computes a loss and the factors backpropagation starts from
+template<typename A, typename T, class InputIt>
+A evaluateLoss(LossId loss, ActivationId activation, const T* output, InputIt expected, std::size_t count, T* factors);
+
+/**
+	Squared error may be used with any output activation function.
+	Cross-entropy requires outputs to be probabilities, so it may only be
+	used with softmax, for mutually exclusive classes, or with a logistic
+	function, for independent ones.
+
+	@param[in] loss       Identifier of the loss function
+	@param[in] activation Identifier of the activation function of the
+	                      output layer
+
+	@returns Whether the combination is supported
+*/
+constexpr bool isCompatible(LossId loss, ActivationId activation) {
+	return loss == LossId::squaredError || activation == ActivationId::softmax
+		|| activation == ActivationId::logistic || activation == ActivationId::fastLogistic;
+}
+
+/**
+	Stores the differences @f$ y - t @f$ between the output and the expected
+	output in `factors` and returns the loss. For squared error, the loss is
+	@f$ \sum_i (y_i - t_i)^2 @f$ and the factors still have to be
+	multiplied by the derivative of the output activation function. For
+	cross-entropy, the loss is @f$ -\sum_i t_i \ln y_i @f$ with softmax and
+	@f$ -\sum_i (t_i \ln y_i + (1 - t_i) \ln (1 - y_i)) @f$ with a logistic
+	function, and the factors already are its gradient with respect to the
+	sums of the output layer, so the derivative must be skipped. This
+	avoids the vanishing gradient of a saturated output. Probabilities are
+	clamped away from zero before taking logarithms.
+
+	@tparam     A          Type in which the loss is computed
+	@tparam     InputIt    Must meet the requirements of `InputIterator`
+	@param[in]  loss       Identifier of the loss function
+	@param[in]  activation Identifier of the activation function of the
+	                       output layer, compatible with `loss`
+	@param[in]  output     The beginning of the output range
+	@param[in]  expected   The beginning of the expected output range
+	@param[in]  count      Number of outputs
+	@param[out] factors    The beginning of the factor range
+
+	@returns Loss of the output
+*/
+template<typename A, typename T, class InputIt>
+A evaluateLoss(LossId loss, ActivationId activation, const T* output, InputIt expected, std::size_t count, T* factors) {
+	const A tiny = std::numeric_limits<A>::min();
+	A result = A();
+	for (std::size_t i = 0; i < count; ++i, ++expected) {
+		const T t = *expected;
+		factors[i] = output[i] - t;
+		if (loss == LossId::squaredError) {
+			result = result + A(factors[i]) * A(factors[i]);
+		} else if (activation == ActivationId::softmax) {
+			result -= A(t) * std::log(std::max(A(output[i]), tiny));
+		} else {
+			result -= A(t) * std::log(std::max(A(output[i]), tiny)) + (1 - A(t)) * std::log(std::max(1 - A(output[i]), tiny));
+		}
+	}
+	return result;
+}
+
+}
+
+#endif
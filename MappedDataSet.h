@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef MAPPED_DATA_SET_H_
+#define MAPPED_DATA_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "DataSetFile.h"
+#include "MemoryMappedFile.h"
+
+namespace mlp {
+
+/// Template class representing a read-only data set backed by a mapped file
+/**
+	A mapped data set maps a file in the binary data set format into memory
+	and exposes its tests in place. Pages are read by the operating system
+	on first access and, being clean, may be evicted under memory pressure,
+	so the data set may be much larger than the available memory. It
+	provides the same test accessors as `DataSet` and may be passed to
+	`PerceptronTrainer::train` in its place; a shuffle window keeps such
+	training streaming through the file rather than reading it at random.
+
+	@tparam T Data type of stored values, `float` or `double`
+*/
+template<typename T>
+class MappedDataSet {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Maps a data set file
+	explicit MappedDataSet(const std::string& path);
+	/// Obtains number of tests
+	std::size_t size() const;
+	/// Obtains size of test input
+	std::size_t inputSize() const;
+	/// Obtains size of test output
+	std::size_t outputSize() const;
+	/// Obtains input of a test
+	const T* input(std::size_t index) const;
+	/// Obtains expected output of a test
+	const T* output(std::size_t index) const;
+private:
+	static_assert(std::is_floating_point_v<T>, "data set files store floating point values");
+	MemoryMappedFile file;
+	const T* rows = nullptr;
+	std::size_t inSize;
+	std::size_t outSize;
+	std::size_t testCount;
+};
+
+/**
+	@param[in] path Path to the data set file
+
+	@throws std::system_error  If the file cannot be mapped
+	@throws std::runtime_error If the file is not a valid data set file for
+	                           value type `T`
+*/
+template<typename T>
+MappedDataSet<T>::MappedDataSet(const std::string& path)
+	: file(path) {
+	using namespace dataSetFormat;
+	const unsigned char* data = file.data();
+	if (file.size() < headerSize || std::memcmp(data, magic, sizeof magic) != 0) {
+		throw std::runtime_error(path + " is not a data set file");
+	}
+	std::uint32_t fields[3];
+	std::uint64_t sizes[3];
+	std::memcpy(fields, data + 4, sizeof fields);
+	std::memcpy(sizes, data + 16, sizeof sizes);
+	if (fields[0] != version) {
+		throw std::runtime_error(path + " has unsupported data set format version");
+	}
+	if (fields[1] != byteOrderMark) {
+		throw std::runtime_error(path + " has foreign byte order");
+	}
+	if (fields[2] != sizeof(T)) {
+		throw std::runtime_error(path + " has different value type");
+	}
+	inSize = sizes[0];
+	outSize = sizes[1];
+	testCount = sizes[2];
+	const std::size_t available = file.size() - headerSize;
+	if (inSize > std::numeric_limits<std::size_t>::max() - outSize || inSize + outSize > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+		throw std::runtime_error(path + " is truncated or corrupted");
+	}
+	const std::size_t rowSize = (inSize + outSize) * sizeof(T);
+	if (rowSize != 0 ? testCount != available / rowSize || available % rowSize != 0 : testCount != 0 || available != 0) {
+		throw std::runtime_error(path + " is truncated or corrupted");
+	}
+	rows = reinterpret_cast<const T*>(data + headerSize);
+}
+
+/**
+	@returns Number of tests in the data set
+*/
+template<typename T>
+std::size_t MappedDataSet<T>::size() const {
+	return testCount;
+}
+
+/**
+	@returns Size of test input
+*/
+template<typename T>
+std::size_t MappedDataSet<T>::inputSize() const {
+	return inSize;
+}
+
+/**
+	@returns Size of test output
+*/
+template<typename T>
+std::size_t MappedDataSet<T>::outputSize() const {
+	return outSize;
+}
+
+/**
+	@param[in] index Index of the test, which must be less than `size()`
+
+	@returns Pointer to the beginning of the input of the test
+*/
+template<typename T>
+const T* MappedDataSet<T>::input(std::size_t index) const {
+	return rows + index * (inSize + outSize);
+}
+
+/**
+	@param[in] index Index of the test, which must be less than `size()`
+
+	@returns Pointer to the beginning of the expected output of the test
+*/
+template<typename T>
+const T* MappedDataSet<T>::output(std::size_t index) const {
+	return rows + index * (inSize + outSize) + inSize;
+}
+
+}
+
+#endif
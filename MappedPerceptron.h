@@ -0,0 +1,237 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef MAPPED_PERCEPTRON_H_
+#define MAPPED_PERCEPTRON_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "ActivationFunction.h"
+#include "InferenceContext.h"
+#include "Kernels.h"
+#include "MemoryMappedFile.h"
+#include "ModelFile.h"
+#include "PointerTraits.h"
+
+namespace mlp {
+
+/// Template class representing a read-only perceptron backed by a mapped model file
+/**
+	A mapped perceptron maps a file written by `saveModel` into memory and
+	runs inference directly from the weight and bias blocks of the mapping,
+	without copying them. Opening a model therefore takes time proportional
+	to the number of layers rather than to the number of weights, and pages
+	of the file are shared by all processes mapping it. The perceptron
+	cannot be trained.
+
+	@tparam T Value type of the model, `float` or `double`
+*/
+template<typename T>
+class MappedPerceptron {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Maps a model file
+	explicit MappedPerceptron(const std::string& path, bool verify = true);
+	/// Obtains number of layers of the perceptron
+	std::size_t size() const;
+	/// Obtains size of the widest layer, including the input
+	std::size_t width() const;
+	/// Obtains size of perceptron input
+	std::size_t inputSize() const;
+	/// Obtains size of perceptron output
+	std::size_t outputSize() const;
+	/// Produces neural network output based on provided input data
+	template<class InputIt, class OutputIt>
+	void test(InputIt first, OutputIt out) const;
+	/// Produces neural network output using given buffers
+	template<class InputIt, class OutputIt>
+	void test(InputIt first, OutputIt out, InferenceContext<T>& context) const;
+	/// Produces neural network output for a batch of inputs
+	template<class InputIt, class OutputIt>
+	void testBatch(InputIt first, std::size_t batchSize, OutputIt out) const;
+	/// Produces neural network output for a batch of inputs using given buffers
+	template<class InputIt, class OutputIt>
+	void testBatch(InputIt first, std::size_t batchSize, OutputIt out, InferenceContext<T>& context) const;
+private:
+	template<class InputIt>
+	const T* forward(InputIt first, std::size_t count, InferenceContext<T>& context) const;
+	MemoryMappedFile file;
+	ModelView<T> view;
+	std::vector<ActivationFunction<T>> activations;
+};
+
+/**
+	Maps the file at `path` and validates it as by `ModelView`. The
+	mapping is kept for the lifetime of the object.
+
+	@param[in] path   Path to the model file
+	@param[in] verify Whether to verify the checksum, which reads the whole
+	                  file
+
+	@throws std::system_error  If the file cannot be mapped
+	@throws std::runtime_error If the file is not a valid model file for
+	                           value type `T`
+*/
+template<typename T>
+MappedPerceptron<T>::MappedPerceptron(const std::string& path, bool verify)
+	: file(path), view(file.data(), file.size(), verify) {
+	activations.reserve(view.size());
+	for (std::size_t i = 0; i < view.size(); ++i) {
+		activations.emplace_back(view.layer(i).activation);
+	}
+}
+
+/**
+	@returns Size of the perceptron, i.e. number of neuron layers
+*/
+template<typename T>
+std::size_t MappedPerceptron<T>::size() const {
+	return view.size();
+}
+
+/**
+	@returns Maximum of the input size and sizes of all layers
+*/
+template<typename T>
+std::size_t MappedPerceptron<T>::width() const {
+	std::size_t result = view.inputSize();
+	for (std::size_t i = 0; i < view.size(); ++i) {
+		result = std::max(result, view.layer(i).size);
+	}
+	return result;
+}
+
+/**
+	@returns Size of the expected input
+*/
+template<typename T>
+std::size_t MappedPerceptron<T>::inputSize() const {
+	return view.inputSize();
+}
+
+/**
+	@returns Size of the final layer, or of the input if there are no layers
+*/
+template<typename T>
+std::size_t MappedPerceptron<T>::outputSize() const {
+	return view.size() == 0 ? view.inputSize() : view.layer(view.size() - 1).size;
+}
+
+/**
+	Equivalent to calling the overload taking an inference context with
+	a context constructed for the duration of the call.
+
+	@tparam     InputIt  Must meet the requirements of `InputIterator`
+	@tparam     OutputIt Must meet the requirements of `OutputIterator`
+	@param[in]  first    The beginning of the input range
+	@param[out] out      The beginning of the destination range
+*/
+template<typename T>
+template<class InputIt, class OutputIt>
+void MappedPerceptron<T>::test(InputIt first, OutputIt out) const {
+	InferenceContext<T> context(width());
+	test(first, out, context);
+}
+
+/**
+	Behaves like `MultiLayerPerceptron::test` with a context. Concurrent
+	calls are safe as long as each thread uses its own context.
+
+	@tparam        InputIt  Must meet the requirements of `InputIterator`
+	@tparam        OutputIt Must meet the requirements of `OutputIterator`
+	@param[in]     first    The beginning of the input range
+	@param[out]    out      The beginning of the destination range
+	@param[in,out] context  Buffers for intermediate results
+*/
+template<typename T>
+template<class InputIt, class OutputIt>
+void MappedPerceptron<T>::test(InputIt first, OutputIt out, InferenceContext<T>& context) const {
+	std::copy_n(forward(first, 1, context), outputSize(), out);
+}
+
+/**
+	Equivalent to calling the overload taking an inference context with
+	a context constructed for the duration of the call.
+
+	@tparam     InputIt   Must meet the requirements of `InputIterator`
+	@tparam     OutputIt  Must meet the requirements of `OutputIterator`
+	@param[in]  first     The beginning of the input range
+	@param[in]  batchSize Number of inputs
+	@param[out] out       The beginning of the destination range
+*/
+template<typename T>
+template<class InputIt, class OutputIt>
+void MappedPerceptron<T>::testBatch(InputIt first, std::size_t batchSize, OutputIt out) const {
+	InferenceContext<T> context(width(), batchSize);
+	testBatch(first, batchSize, out, context);
+}
+
+/**
+	Behaves like `MultiLayerPerceptron::testBatch` with a context.
+
+	@tparam        InputIt   Must meet the requirements of `InputIterator`
+	@tparam        OutputIt  Must meet the requirements of `OutputIterator`
+	@param[in]     first     The beginning of the input range
+	@param[in]     batchSize Number of inputs
+	@param[out]    out       The beginning of the destination range
+	@param[in,out] context   Buffers for intermediate results
+*/
+template<typename T>
+template<class InputIt, class OutputIt>
+void MappedPerceptron<T>::testBatch(InputIt first, std::size_t batchSize, OutputIt out, InferenceContext<T>& context) const {
+	std::copy_n(forward(first, batchSize, context), batchSize * outputSize(), out);
+}
+
+template<typename T>
+template<class InputIt>
+const T* MappedPerceptron<T>::forward(InputIt first, std::size_t count, InferenceContext<T>& context) const {
+	context.reserve(width(), count);
+	const T* input;
+	if constexpr (isPointerTo<InputIt, T>) {
+		input = first;
+	} else {
+		std::copy_n(first, count * view.inputSize(), context.back());
+		input = context.back();
+	}
+	for (std::size_t i = 0; i < view.size(); ++i) {
+		const auto& layer = view.layer(i);
+		T* output = context.front();
+		if (count == 1) {
+			kernels::gemv(layer.weights, layer.biases, input, layer.size, layer.inputSize, output);
+		} else {
+			kernels::gemm(input, count, layer.weights, layer.biases, layer.size, layer.inputSize, output);
+		}
+		activations[i].applyBatch(output, count, layer.size, output);
+		context.swap();
+		input = output;
+	}
+	return input;
+}
+
+}
+
+#endif
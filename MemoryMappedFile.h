@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef MEMORY_MAPPED_FILE_H_
+#define MEMORY_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mlp {
+
+/// Class representing a read-only memory mapping of a whole file
+/**
+	The file is mapped on construction and unmapped on destruction. The
+	mapping starts at a page boundary, so data stored in the file at
+	offsets aligned to a cache line are equally aligned in memory. The
+	object is movable but not copyable. Uses `mmap` on POSIX systems and
+	`MapViewOfFile` on Windows.
+*/
+class MemoryMappedFile {
+public:
+	/// Maps a file
+	explicit MemoryMappedFile(const std::string& path);
+	/// Move constructor
+	MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+	/// Move assignment operator
+	MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+	/// Unmaps the file
+	~MemoryMappedFile();
+	/// Obtains the beginning of the mapped contents
+	const unsigned char* data() const;
+	/// Obtains size of the file in bytes
+	std::size_t size() const;
+private:
+	void unmap() noexcept;
+	const unsigned char* address = nullptr;
+	std::size_t length = 0;
+};
+
+/**
+	Maps the whole file for reading. An empty file is not mapped, and
+	`data()` returns a null pointer for it.
+
+	@param[in] path Path to the file
+
+	@throws std::system_error If the file cannot be opened or mapped
+*/
+inline MemoryMappedFile::MemoryMappedFile(const std::string& path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "cannot open " + path);
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		const DWORD error = GetLastError();
+		CloseHandle(file);
+		throw std::system_error(static_cast<int>(error), std::system_category(), "cannot stat " + path);
+	}
+	length = static_cast<std::size_t>(fileSize.QuadPart);
+	if (length != 0) {
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const DWORD error = GetLastError();
+		CloseHandle(file);
+		if (!mapping) {
+			throw std::system_error(static_cast<int>(error), std::system_category(), "cannot map " + path);
+		}
+		address = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		const DWORD viewError = GetLastError();
+		CloseHandle(mapping);
+		if (!address) {
+			throw std::system_error(static_cast<int>(viewError), std::system_category(), "cannot map " + path);
+		}
+	} else {
+		CloseHandle(file);
+	}
+#else
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw std::system_error(errno, std::system_category(), "cannot open " + path);
+	}
+	struct stat status;
+	if (::fstat(file, &status) != 0) {
+		const int error = errno;
+		::close(file);
+		throw std::system_error(error, std::system_category(), "cannot stat " + path);
+	}
+	length = static_cast<std::size_t>(status.st_size);
+	if (length != 0) {
+		void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, file, 0);
+		const int error = errno;
+		::close(file);
+		if (mapping == MAP_FAILED) {
+			throw std::system_error(error, std::system_category(), "cannot map " + path);
+		}
+		address = static_cast<const unsigned char*>(mapping);
+	} else {
+		::close(file);
+	}
+#endif
+}
+
+/**
+	Takes over the mapping of `other`, which is left empty.
+
+	@param[in,out] other The object to move from
+*/
+inline MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+	: address(std::exchange(other.address, nullptr)), length(std::exchange(other.length, 0)) {}
+
+/**
+	Unmaps the current file and takes over the mapping of `other`, which is
+	left empty.
+
+	@param[in,out] other The object to move from
+
+	@returns `*this`
+*/
+inline MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept {
+	if (this != &other) {
+		unmap();
+		address = std::exchange(other.address, nullptr);
+		length = std::exchange(other.length, 0);
+	}
+	return *this;
+}
+
+/**
+	Pointers obtained from `data()` become invalid.
+*/
+inline MemoryMappedFile::~MemoryMappedFile() {
+	unmap();
+}
+
+/**
+	@returns Pointer to the first byte of the file, or a null pointer if the
+	         file is empty
+*/
+inline const unsigned char* MemoryMappedFile::data() const {
+	return address;
+}
+
+/**
+	@returns Size of the file in bytes
+*/
+inline std::size_t MemoryMappedFile::size() const {
+	return length;
+}
+
+inline void MemoryMappedFile::unmap() noexcept {
+	if (address) {
+#ifdef _WIN32
+		UnmapViewOfFile(address);
+#else
+		::munmap(const_cast<unsigned char*>(address), length);
+#endif
+		address = nullptr;
+		length = 0;
+	}
+}
+
+}
+
+#endif
@@ -0,0 +1,412 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef MODEL_FILE_H_
+#define MODEL_FILE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ActivationFunction.h"
+#include "ActivationId.h"
+#include "AlignedAllocator.h"
+#include "MultiLayerPerceptron.h"
+#include "NeuronLayerSpecification.h"
+
+namespace mlp {
+
+/// Constants and helpers of the binary model format
+/**
+	A model file consists of a 64-byte header, a table of layers and
+	a sequence of weight and bias blocks. All values are stored in the byte
+	order of the machine that wrote the file, which is recorded in the
+	header so that a mismatch is detected rather than misread.
+
+	The header holds, in order: the magic bytes `MLPM`, the 32-bit format
+	version, the 32-bit byte order mark `0x01020304`, the 32-bit size of
+	the value type in bytes, then the 64-bit input size, number of layers,
+	file size and checksum, followed by zero padding.
+
+	Each entry of the layer table occupies 16 bytes: the 64-bit number of
+	neurons, the 8-bit `ActivationId` and zero padding. Then, for each layer,
+	come the row-major weight matrix and the bias vector. The table and
+	every block start at a multiple of 64 bytes and are padded with zeros
+	to the next multiple, so that a file mapped into memory at a page
+	boundary can be used for inference as is.
+
+	The checksum is a 64-bit FNV-1a hash of the file contents following the
+	header, computed over 64-bit words.
+*/
+namespace modelFormat {
+
+/// Magic bytes opening every model file
+constexpr char magic[4] = {'M', 'L', 'P', 'M'};
+/// Version of the format written by `saveModel`
+constexpr std::uint32_t version = 1;
+/// Value stored to identify the byte order
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+/// Size of the header in bytes
+constexpr std::size_t headerSize = 64;
+/// Size of a layer table entry in bytes
+constexpr std::size_t layerEntrySize = 16;
+/// Alignment of the layer table and of every block in bytes
+constexpr std::size_t alignment = 64;
+
+/// Rounds an offset up to the alignment of blocks
+constexpr std::size_t align(std::size_t offset);
+/// Computes the checksum of a range of bytes
+std::uint64_t checksum(const unsigned char* data, std::size_t size);
+/// Stores an integer at given address
+template<typename U>
+void store(unsigned char* data, U value);
+/// Loads an integer from given address
+template<typename U>
+U load(const unsigned char* data);
+
+/**
+	@param[in] offset Offset in bytes
+
+	@returns The least multiple of `alignment` not less than `offset`
+*/
+constexpr std::size_t align(std::size_t offset) {
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+/**
+	@param[in] data The beginning of the range
+	@param[in] size Size of the range in bytes, which must be a multiple of 8
+
+	@returns 64-bit FNV-1a hash of the range, processed in 64-bit words
+*/
+inline std::uint64_t checksum(const unsigned char* data, std::size_t size) {
+	std::uint64_t hash = 14695981039346656037ull;
+	for (std::size_t i = 0; i < size; i += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data + i, 8);
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+	return hash;
+}
+
+/**
+	@tparam    U     An integer type
+	@param[in] data  Destination address
+	@param[in] value Value to store in native byte order
+*/
+template<typename U>
+void store(unsigned char* data, U value) {
+	std::memcpy(data, &value, sizeof value);
+}
+
+/**
+	@tparam    U    An integer type
+	@param[in] data Source address
+
+	@returns Value stored in native byte order
+*/
+template<typename U>
+U load(const unsigned char* data) {
+	U value;
+	std::memcpy(&value, data, sizeof value);
+	return value;
+}
+
+}
+
+/// Template class representing a validated binary model
+/**
+	A model view interprets a range of bytes holding a model file written
+	by `saveModel` without copying it. The layers refer directly to the
+	weight and bias blocks within the range, which must therefore outlive
+	the view.
+
+	@tparam T Value type of the model, `float` or `double`
+*/
+template<typename T>
+class ModelView {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Structure describing a layer of the model
+	struct Layer {
+		/// Number of neurons
+		std::size_t size;
+		/// Size of layer input
+		std::size_t inputSize;
+		/// Activation function identifier
+		ActivationId activation;
+		/// The beginning of the row-major weight matrix
+		const T* weights;
+		/// The beginning of the bias vector
+		const T* biases;
+	};
+	/// Validates a model file stored in memory
+	ModelView(const unsigned char* data, std::size_t size, bool verify = true);
+	/// Obtains size of model input
+	std::size_t inputSize() const;
+	/// Obtains number of layers
+	std::size_t size() const;
+	/// Obtains a layer of the model
+	const Layer& layer(std::size_t index) const;
+private:
+	static_assert(std::is_floating_point_v<T>, "model files store floating point values");
+	std::size_t inSize;
+	std::vector<Layer> layers;
+};
+
+/// Writes a perceptron to a stream in the binary model format
+template<typename T, typename A>
+void saveModel(const MultiLayerPerceptron<T, A>& perceptron, std::ostream& out);
+/// Writes a perceptron to a file in the binary model format
+template<typename T, typename A>
+void saveModel(const MultiLayerPerceptron<T, A>& perceptron, const std::string& path);
+/// Reads a perceptron from a file in the binary model format
+template<typename T, typename A = T>
+MultiLayerPerceptron<T, A> loadModel(const std::string& path);
+
+/**
+	Validates the header, the layer table and, if `verify` is `true`, the
+	checksum, then locates the blocks of every layer. Skipping the checksum
+	avoids reading the whole file up front, which matters for large mapped
+	models whose integrity is ensured otherwise.
+
+	@param[in] data   The beginning of the file contents, aligned to at
+	                  least `alignof(T)`
+	@param[in] size   Size of the file contents in bytes
+	@param[in] verify Whether to verify the checksum
+
+	@throws std::runtime_error If the contents are not a valid model file of
+	                           a supported version for value type `T`
+*/
+template<typename T>
+ModelView<T>::ModelView(const unsigned char* data, std::size_t size, bool verify) {
+	using namespace modelFormat;
+	if (size < headerSize || std::memcmp(data, magic, sizeof magic) != 0) {
+		throw std::runtime_error("not a model file");
+	}
+	if (load<std::uint32_t>(data + 4) != version) {
+		throw std::runtime_error("unsupported model format version");
+	}
+	if (load<std::uint32_t>(data + 8) != byteOrderMark) {
+		throw std::runtime_error("model file has foreign byte order");
+	}
+	if (load<std::uint32_t>(data + 12) != sizeof(T)) {
+		throw std::runtime_error("model file has different value type");
+	}
+	if (reinterpret_cast<std::uintptr_t>(data) % alignof(T) != 0) {
+		throw std::runtime_error("model file contents are misaligned");
+	}
+	const std::uint64_t count = load<std::uint64_t>(data + 24);
+	if (load<std::uint64_t>(data + 32) != size || size % 8 != 0 || count > (size - headerSize) / layerEntrySize) {
+		throw std::runtime_error("model file is truncated or corrupted");
+	}
+	if (verify && load<std::uint64_t>(data + 40) != checksum(data + headerSize, size - headerSize)) {
+		throw std::runtime_error("model file checksum mismatch");
+	}
+	inSize = load<std::uint64_t>(data + 16);
+	layers.reserve(count);
+	std::size_t offset = align(headerSize + count * layerEntrySize);
+	std::size_t inputs = inSize;
+	for (std::size_t i = 0; i < count; ++i) {
+		const unsigned char* entry = data + headerSize + i * layerEntrySize;
+		const std::uint64_t neurons = load<std::uint64_t>(entry);
+		const auto activation = static_cast<ActivationId>(entry[8]);
+		if (activation == ActivationId::custom || activation > ActivationId::softmax) {
+			throw std::runtime_error("model file has unknown activation function");
+		}
+		if (offset > size) {
+			throw std::runtime_error("model file is truncated or corrupted");
+		}
+		const std::size_t available = (size - offset) / sizeof(T);
+		if (neurons > available || (neurons != 0 && inputs > available / neurons)) {
+			throw std::runtime_error("model file is truncated or corrupted");
+		}
+		const T* weights = reinterpret_cast<const T*>(data + offset);
+		offset = align(offset + neurons * inputs * sizeof(T));
+		if (offset > size || neurons > (size - offset) / sizeof(T)) {
+			throw std::runtime_error("model file is truncated or corrupted");
+		}
+		const T* biases = reinterpret_cast<const T*>(data + offset);
+		offset = align(offset + neurons * sizeof(T));
+		layers.push_back(Layer{neurons, inputs, activation, weights, biases});
+		inputs = neurons;
+	}
+	if (offset != size) {
+		throw std::runtime_error("model file is truncated or corrupted");
+	}
+}
+
+/**
+	@returns Size of the expected input
+*/
+template<typename T>
+std::size_t ModelView<T>::inputSize() const {
+	return inSize;
+}
+
+/**
+	@returns Number of layers of the model
+*/
+template<typename T>
+std::size_t ModelView<T>::size() const {
+	return layers.size();
+}
+
+/**
+	@param[in] index Index of the layer, which must be less than `size()`
+
+	@returns Reference to the layer description
+*/
+template<typename T>
+const typename ModelView<T>::Layer& ModelView<T>::layer(std::size_t index) const {
+	return layers[index];
+}
+
+/**
+	Writes topology, activation function identifiers, weights and biases of
+	`perceptron` in the current version of the format. Changes memorized
+	for training are not saved.
+
+	@param[in]  perceptron The perceptron to save
+	@param[out] out        The destination stream, opened in binary mode
+
+	@throws std::invalid_argument If any layer uses a custom activation
+	                              function, which cannot be identified
+	@throws std::runtime_error    If writing fails
+*/
+template<typename T, typename A>
+void saveModel(const MultiLayerPerceptron<T, A>& perceptron, std::ostream& out) {
+	using namespace modelFormat;
+	static_assert(std::is_floating_point_v<T>, "model files store floating point values");
+	const std::size_t count = perceptron.size();
+	std::size_t size = align(headerSize + count * layerEntrySize);
+	for (std::size_t i = 0; i < count; ++i) {
+		const auto& layer = perceptron.layer(i);
+		if (layer.activation.id() == ActivationId::custom) {
+			throw std::invalid_argument("custom activation functions cannot be saved");
+		}
+		size = align(size + layer.group.size() * layer.group.inputSize() * sizeof(T));
+		size = align(size + layer.group.size() * sizeof(T));
+	}
+	std::vector<unsigned char> buffer(size);
+	unsigned char* data = buffer.data();
+	std::memcpy(data, magic, sizeof magic);
+	store<std::uint32_t>(data + 4, version);
+	store<std::uint32_t>(data + 8, byteOrderMark);
+	store<std::uint32_t>(data + 12, sizeof(T));
+	store<std::uint64_t>(data + 16, perceptron.inputSize());
+	store<std::uint64_t>(data + 24, count);
+	store<std::uint64_t>(data + 32, size);
+	std::size_t offset = align(headerSize + count * layerEntrySize);
+	for (std::size_t i = 0; i < count; ++i) {
+		const auto& group = perceptron.layer(i).group;
+		unsigned char* entry = data + headerSize + i * layerEntrySize;
+		store<std::uint64_t>(entry, group.size());
+		entry[8] = static_cast<unsigned char>(perceptron.layer(i).activation.id());
+		const std::size_t weightBytes = group.size() * group.inputSize() * sizeof(T);
+		std::memcpy(data + offset, group.weightData(), weightBytes);
+		offset = align(offset + weightBytes);
+		std::memcpy(data + offset, group.biasData(), group.size() * sizeof(T));
+		offset = align(offset + group.size() * sizeof(T));
+	}
+	store<std::uint64_t>(data + 40, checksum(data + headerSize, size - headerSize));
+	if (!out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size))) {
+		throw std::runtime_error("cannot write model");
+	}
+}
+
+/**
+	Creates or truncates the file at `path` and writes `perceptron` to it
+	as by the stream overload.
+
+	@param[in] perceptron The perceptron to save
+	@param[in] path       Path to the destination file
+
+	@throws std::invalid_argument If any layer uses a custom activation
+	                              function, which cannot be identified
+	@throws std::runtime_error    If the file cannot be written
+*/
+template<typename T, typename A>
+void saveModel(const MultiLayerPerceptron<T, A>& perceptron, const std::string& path) {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		throw std::runtime_error("cannot open " + path);
+	}
+	saveModel(perceptron, out);
+	out.close();
+	if (!out) {
+		throw std::runtime_error("cannot write " + path);
+	}
+}
+
+/**
+	Reads the whole file, validates it including the checksum and copies
+	weights and biases into a newly constructed perceptron, which may then
+	be trained further. For inference only, `MappedPerceptron` avoids the
+	copy.
+
+	@param[in] path Path to the model file
+
+	@returns The stored perceptron
+
+	@throws std::runtime_error If the file cannot be read or is not a valid
+	                           model file for value type `T`
+*/
+template<typename T, typename A>
+MultiLayerPerceptron<T, A> loadModel(const std::string& path) {
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in) {
+		throw std::runtime_error("cannot open " + path);
+	}
+	AlignedVector<unsigned char> buffer(static_cast<std::size_t>(in.tellg()));
+	in.seekg(0);
+	if (!in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()))) {
+		throw std::runtime_error("cannot read " + path);
+	}
+	const ModelView<T> view(buffer.data(), buffer.size());
+	std::vector<NeuronLayerSpecification<T>> specs;
+	specs.reserve(view.size());
+	for (std::size_t i = 0; i < view.size(); ++i) {
+		specs.push_back({view.layer(i).size, ActivationFunction<T>(view.layer(i).activation)});
+	}
+	MultiLayerPerceptron<T, A> perceptron(view.inputSize(), specs.begin(), specs.end());
+	for (std::size_t i = 0; i < view.size(); ++i) {
+		const auto& layer = view.layer(i);
+		auto& group = perceptron.layer(i).group;
+		std::copy_n(layer.weights, layer.size * layer.inputSize, group.weightData());
+		std::copy_n(layer.biases, layer.size, group.biasData());
+	}
+	return perceptron;
+}
+
+}
+
+#endif
@@ -29,10 +29,18 @@
 #include <cstddef>
 #include <functional>
 #include <initializer_list>
+#include <numeric>
+#include <stdexcept>
 #include <utility>
 #include <vector>
+#include "Gradient.h"
+#include "InferenceContext.h"
+#include "Loss.h"
 #include "NeuronLayerSpecification.h"
 #include "NeuronLayer.h"
+#include "PointerTraits.h"
+#include "Profiler.h"
+#include "TrainingWorkspace.h"
 
 namespace mlp {
 
@@ -41,15 +49,36 @@ namespace mlp {
 	A multilayer perceptron is a neural network consisting of some number
 	of neuron layers.
 
+	Weights, biases and activations are stored and computed in type `T`,
+	whereas changes to weights and biases memorized for training, as well
+	as training errors, are accumulated in type `A`. Choosing `float` for
+	`T` and `double` for `A` halves memory traffic and doubles the vector
+	width of the forward and backward passes compared to `double`, while
+	sums over many tests keep `double` precision.
+
+	Training minimizes squared error unless another loss is selected by
+	`setLoss`. Cross-entropy with a softmax or logistic output layer
+	starts backpropagation from the gradient with respect to the sums of
+	that layer, skipping its derivative, which keeps classifiers learning
+	when their outputs saturate. The loss is not stored in model files.
+
+	If the library is compiled with `MLP_PROFILING` defined, every phase of
+	processing every layer in `test`, `testBatch`, `train`, `accumulate`
+	and `apply` is timed and recorded by `Profiler::instance()`.
+
 	@tparam T Must meet the requirements of `NumericType` and for objects
 	          `a, b` of type `T`, the expressions `a + b` and `a * b` must
 	          be well-formed and be of type assignable to T.
+	@tparam A Type in which changes and errors are accumulated; `T` or
+	          a wider type
 */
-template<typename T>
+template<typename T, typename A = T>
 class MultiLayerPerceptron {
 public:
 	/// Data type the class operates on
 	using ValueType = T;
+	/// Data type changes and errors are accumulated in
+	using AccumulatorType = A;
 	/// Constructs the perceptron from range
 	template<class InputIt>
 	MultiLayerPerceptron(std::size_t inputSize, InputIt first, InputIt last);
@@ -57,14 +86,48 @@ public:
 	MultiLayerPerceptron(std::size_t inputSize, std::initializer_list<NeuronLayerSpecification<T>> init);
 	/// Obtains number of layers of the perceptron
 	std::size_t size() const;
+	/// Obtains size of the widest layer, including the input
+	std::size_t width() const;
+	/// Obtains size of perceptron input
+	std::size_t inputSize() const;
+	/// Obtains size of perceptron output
+	std::size_t outputSize() const;
+	/// Obtains a layer of the perceptron
+	NeuronLayer<T, A>& layer(std::size_t index);
+	/// Obtains a layer of the perceptron
+	const NeuronLayer<T, A>& layer(std::size_t index) const;
+	/// Sets loss function minimized by training
+	void setLoss(LossId id);
+	/// Obtains loss function minimized by training
+	LossId loss() const;
 	/// Produces neural network output based on provided input data
 	template<class ForwardIt, class OutputIt>
 	void test(ForwardIt first, OutputIt out) const;
+	/// Produces neural network output using given buffers
+	template<class InputIt, class OutputIt>
+	void test(InputIt first, OutputIt out, InferenceContext<T>& context) const;
+	/// Produces neural network output for a batch of inputs
+	template<class InputIt, class OutputIt>
+	void testBatch(InputIt first, std::size_t batchSize, OutputIt out) const;
+	/// Produces neural network output for a batch of inputs using given buffers
+	template<class InputIt, class OutputIt>
+	void testBatch(InputIt first, std::size_t batchSize, OutputIt out, InferenceContext<T>& context) const;
 	/// Trains neural network based on provided input data and expected output
 	template<class InputIt1, class InputIt2>
-	T train(InputIt1 first, InputIt2 expected);
+	A train(InputIt1 first, InputIt2 expected);
+	/// Trains neural network using given buffers
+	template<class InputIt1, class InputIt2>
+	A train(InputIt1 first, InputIt2 expected, TrainingWorkspace<T>& workspace);
+	/// Trains neural network and stores changes in an external gradient
+	template<class InputIt1, class InputIt2>
+	A train(InputIt1 first, InputIt2 expected, Gradient<A>& gradient) const;
+	/// Trains neural network and stores changes in an external gradient using given buffers
+	template<class InputIt1, class InputIt2>
+	A train(InputIt1 first, InputIt2 expected, Gradient<A>& gradient, TrainingWorkspace<T>& workspace) const;
+	/// Memorizes changes stored in an external gradient
+	void accumulate(const Gradient<A>& gradient);
 	/// Applies memorized changes to weights and biases.
-	void apply(T rate, T momentum);
+	void apply(A rate, A momentum);
 	/// Generates biases of neurons
 	template<class Generator>
 	void generateBiases(Generator gen);
@@ -74,8 +137,13 @@ public:
 private:
 	template<class InputIt>
 	void construct(std::size_t inputSize, InputIt first, InputIt last);
-	std::size_t inputSize;
-	std::vector<NeuronLayer<T>> layers;
+	template<class InputIt>
+	const T* forward(InputIt first, std::size_t count, InferenceContext<T>& context) const;
+	template<class InputIt1, class InputIt2, class Modify>
+	A propagate(InputIt1 first, InputIt2 expected, TrainingWorkspace<T>& workspace, Modify modify) const;
+	std::size_t inSize;
+	std::vector<NeuronLayer<T, A>> layers;
+	LossId lossId = LossId::squaredError;
 };
 
 /**
@@ -92,9 +160,9 @@ private:
 	@param[in] first     The beginning of the layer specification range
 	@param[in] last      The end of the layer specification range
 */
-template<typename T>
+template<typename T, typename A>
 template<class InputIt>
-MultiLayerPerceptron<T>::MultiLayerPerceptron(std::size_t inputSize, InputIt first, InputIt last) {
+MultiLayerPerceptron<T, A>::MultiLayerPerceptron(std::size_t inputSize, InputIt first, InputIt last) {
 	construct(inputSize, first, last);
 }
 
@@ -108,19 +176,96 @@ MultiLayerPerceptron<T>::MultiLayerPerceptron(std::size_t inputSize, InputIt fir
 	@param[in] inputSize Number of inputs of the perceptron
 	@param[in] init      Initializer list containing layer specifications
 */
-template<typename T>
-MultiLayerPerceptron<T>::MultiLayerPerceptron(std::size_t inputSize, std::initializer_list<NeuronLayerSpecification<T>> init) {
+template<typename T, typename A>
+MultiLayerPerceptron<T, A>::MultiLayerPerceptron(std::size_t inputSize, std::initializer_list<NeuronLayerSpecification<T>> init) {
 	construct(inputSize, init.begin(), init.end());
 }
 
 /**
 	@returns Size of the perceptron, i.e. number of neuron layers
 */
-template<typename T>
-std::size_t MultiLayerPerceptron<T>::size() const {
+template<typename T, typename A>
+std::size_t MultiLayerPerceptron<T, A>::size() const {
 	return layers.size();
 }
 
+/**
+	@returns Maximum of the input size and sizes of all layers
+*/
+template<typename T, typename A>
+std::size_t MultiLayerPerceptron<T, A>::width() const {
+	std::size_t result = inSize;
+	for (const auto& layer : layers) {
+		result = std::max(result, layer.group.size());
+	}
+	return result;
+}
+
+/**
+	@returns Size of the expected input
+*/
+template<typename T, typename A>
+std::size_t MultiLayerPerceptron<T, A>::inputSize() const {
+	return inSize;
+}
+
+/**
+	@returns Size of the final layer, or of the input if there are no layers
+*/
+template<typename T, typename A>
+std::size_t MultiLayerPerceptron<T, A>::outputSize() const {
+	return layers.empty() ? inSize : layers.back().group.size();
+}
+
+/**
+	The layer may be modified, e.g. to load weights and biases, but its
+	group must keep its dimensions.
+
+	@param[in] index Index of the layer, which must be less than `size()`
+
+	@returns Reference to the layer
+*/
+template<typename T, typename A>
+NeuronLayer<T, A>& MultiLayerPerceptron<T, A>::layer(std::size_t index) {
+	return layers[index];
+}
+
+/**
+	@param[in] index Index of the layer, which must be less than `size()`
+
+	@returns Reference to the layer
+*/
+template<typename T, typename A>
+const NeuronLayer<T, A>& MultiLayerPerceptron<T, A>::layer(std::size_t index) const {
+	return layers[index];
+}
+
+/**
+	Selects the loss function evaluated by `train`. Cross-entropy requires
+	the output layer to use a softmax or logistic activation function.
+
+	@param[in] id Identifier of the loss function
+
+	@throws std::invalid_argument If the loss function is not compatible
+	                              with the activation function of the
+	                              output layer
+*/
+template<typename T, typename A>
+void MultiLayerPerceptron<T, A>::setLoss(LossId id) {
+	if (!layers.empty() && !isCompatible(id, layers.back().activation.id())) {
+		throw std::invalid_argument("loss function incompatible with output activation function");
+	}
+	lossId = id;
+}
+
+/**
+	@returns Identifier of the loss function
+*/
+template<typename T, typename A>
+LossId MultiLayerPerceptron<T, A>::loss() const {
+	return lossId;
+}
+
 /**
 	Interprets the range `[first, first + inputSize)` as perceptron input and
 	feeds it to the neural network. The output of the final layer is then
@@ -131,24 +276,69 @@ std::size_t MultiLayerPerceptron<T>::size() const {
 	@param[in]  first     The beginning of the input range
 	@param[out] out       The beginning of the destination range
 */
-template<typename T>
+template<typename T, typename A>
 template<class ForwardIt, class OutputIt>
-void MultiLayerPerceptron<T>::test(ForwardIt first, OutputIt out) const {
-	if (size() == 0) {
-		std::copy_n(first, inputSize, out);
-	} else {
-		std::vector<T> inter(layers.front().group.size());
-		layers.front().group.process(first, inter.begin());
-		std::transform(inter.begin(), inter.end(), inter.begin(), layers.front().activation);
-		auto operation = [&](const NeuronLayer<T>& layer) {
-			std::vector<T> buffer(layer.group.size());
-			layer.group.process(inter.begin(), buffer.begin());
-			std::transform(buffer.begin(), buffer.end(), buffer.begin(), layer.activation);
-			inter = std::move(buffer);
-		};
-		std::for_each(std::next(layers.begin()), layers.end(), operation);
-		std::copy(inter.begin(), inter.end(), out);
-	}
+void MultiLayerPerceptron<T, A>::test(ForwardIt first, OutputIt out) const {
+	InferenceContext<T> context(width());
+	test(first, out, context);
+}
+
+/**
+	Behaves like the overload without a context, except that intermediate
+	results are stored in `context`, which is grown if necessary. Repeated
+	calls with a context that is already large enough perform no
+	allocations. The perceptron itself is not modified, so concurrent calls
+	are safe as long as each thread uses its own context.
+
+	@tparam        InputIt  Must meet the requirements of `InputIterator`
+	@tparam        OutputIt Must meet the requirements of `OutputIterator`
+	@param[in]     first    The beginning of the input range
+	@param[out]    out      The beginning of the destination range
+	@param[in,out] context  Buffers for intermediate results
+*/
+template<typename T, typename A>
+template<class InputIt, class OutputIt>
+void MultiLayerPerceptron<T, A>::test(InputIt first, OutputIt out, InferenceContext<T>& context) const {
+	std::copy_n(forward(first, 1, context), outputSize(), out);
+}
+
+/**
+	Equivalent to calling the overload taking an inference context with
+	a context constructed for the duration of the call.
+
+	@tparam     InputIt   Must meet the requirements of `InputIterator`
+	@tparam     OutputIt  Must meet the requirements of `OutputIterator`
+	@param[in]  first     The beginning of the input range
+	@param[in]  batchSize Number of inputs
+	@param[out] out       The beginning of the destination range
+*/
+template<typename T, typename A>
+template<class InputIt, class OutputIt>
+void MultiLayerPerceptron<T, A>::testBatch(InputIt first, std::size_t batchSize, OutputIt out) const {
+	InferenceContext<T> context(width(), batchSize);
+	testBatch(first, batchSize, out, context);
+}
+
+/**
+	Interprets the range `[first, first + batchSize * inputSize)` as
+	`batchSize` consecutive perceptron inputs and feeds them through the
+	network one layer at a time, so that each layer is a single
+	matrix-matrix product. The outputs of the final layer are then placed
+	consecutively in the range beginning at `out`. Intermediate results
+	are stored in `context`, which is grown if necessary; a context that
+	is already large enough is reused without allocating.
+
+	@tparam        InputIt   Must meet the requirements of `InputIterator`
+	@tparam        OutputIt  Must meet the requirements of `OutputIterator`
+	@param[in]     first     The beginning of the input range
+	@param[in]     batchSize Number of inputs
+	@param[out]    out       The beginning of the destination range
+	@param[in,out] context   Buffers for intermediate results
+*/
+template<typename T, typename A>
+template<class InputIt, class OutputIt>
+void MultiLayerPerceptron<T, A>::testBatch(InputIt first, std::size_t batchSize, OutputIt out, InferenceContext<T>& context) const {
+	std::copy_n(forward(first, batchSize, context), batchSize * outputSize(), out);
 }
 
 /**
@@ -162,52 +352,102 @@ void MultiLayerPerceptron<T>::test(ForwardIt first, OutputIt out) const {
 	@param[in] first    The beginning of the input range
 	@param[in] expected The beginning of the expected output range
 */
-template<typename T>
+template<typename T, typename A>
 template<class InputIt1, class InputIt2>
-T MultiLayerPerceptron<T>::train(InputIt1 first, InputIt2 expected) {
-	std::vector<std::vector<T>> sums;
-	std::vector<std::vector<T>> activeSums;
-	std::vector<T> factors(inputSize);
-	sums.reserve(size() + 1);
-	sums.emplace_back(inputSize);
-	activeSums.reserve(size());
-	std::copy_n(first, inputSize, factors.begin());
-	std::copy_n(factors.begin(), inputSize, sums.front().begin());
-	auto operation = [&](const NeuronLayer<T>& layer) {
-		activeSums.push_back(factors);
-		std::vector<T> buffer(layer.group.size());
-		layer.group.process(factors.begin(), buffer.begin());
-		sums.push_back(buffer);
-		std::transform(buffer.begin(), buffer.end(), buffer.begin(), layer.activation);
-		factors = std::move(buffer);
-	};
-	std::for_each(layers.begin(), layers.end(), operation);
-	auto sumIt = sums.rbegin();
-	auto activeSumIt = activeSums.rbegin();
-	std::transform(factors.begin(), factors.end(), expected, factors.begin(), std::minus<T>());
-	T result = std::inner_product(factors.begin(), factors.end(), factors.begin(), T());
-	auto backpropagation = [&](NeuronLayer<T>& layer) {
-		auto& last = *sumIt++;
-		auto& lastActive = *activeSumIt++;
-		std::transform(factors.begin(), factors.end(), last.begin(), factors.begin(), [&](T factor, T sum) {
-			return factor * layer.activation.derivative(sum);
-		});
-		std::vector<T> buffer(lastActive.size());
-		layer.group.modify(factors.begin(), lastActive.begin(), buffer.begin());
-		factors = std::move(buffer);
-	};
-	std::for_each(layers.rbegin(), layers.rend(), backpropagation);
-	return result;
+A MultiLayerPerceptron<T, A>::train(InputIt1 first, InputIt2 expected) {
+	TrainingWorkspace<T> workspace(*this);
+	return train(first, expected, workspace);
+}
+
+/**
+	Behaves like the overload without a workspace, except that intermediate
+	results are stored in `workspace`. Repeated calls with the same
+	workspace perform no allocations.
+
+	@tparam        InputIt1  Must meet the requirements of `InputIterator`
+	@tparam        InputIt2  Must meet the requirements of `InputIterator`
+	@param[in]     first     The beginning of the input range
+	@param[in]     expected  The beginning of the expected output range
+	@param[in,out] workspace Workspace matching the shape of the perceptron
+
+	@returns Loss of the output
+*/
+template<typename T, typename A>
+template<class InputIt1, class InputIt2>
+A MultiLayerPerceptron<T, A>::train(InputIt1 first, InputIt2 expected, TrainingWorkspace<T>& workspace) {
+	return propagate(first, expected, workspace, [&](std::size_t index, const T* factors, const T* args, T* out) {
+		layers[index].group.modify(factors, args, out);
+	});
+}
+
+/**
+	Behaves like the overload without a gradient, except that modifications
+	to weights and biases are added to `gradient` rather than memorized by
+	the perceptron. The perceptron itself is not modified, so concurrent
+	calls with distinct gradients are safe.
+
+	@tparam        InputIt1 Must meet the requirements of `InputIterator`
+	@tparam        InputIt2 Must meet the requirements of `InputIterator`
+	@param[in]     first    The beginning of the input range
+	@param[in]     expected The beginning of the expected output range
+	@param[in,out] gradient Gradient matching the shape of the perceptron
+
+	@returns Loss of the output
+*/
+template<typename T, typename A>
+template<class InputIt1, class InputIt2>
+A MultiLayerPerceptron<T, A>::train(InputIt1 first, InputIt2 expected, Gradient<A>& gradient) const {
+	TrainingWorkspace<T> workspace(*this);
+	return train(first, expected, gradient, workspace);
+}
+
+/**
+	Behaves like the overload without a workspace, except that intermediate
+	results are stored in `workspace`. Repeated calls with the same
+	workspace perform no allocations. Concurrent calls are safe as long as
+	each uses a distinct gradient and a distinct workspace.
+
+	@tparam        InputIt1  Must meet the requirements of `InputIterator`
+	@tparam        InputIt2  Must meet the requirements of `InputIterator`
+	@param[in]     first     The beginning of the input range
+	@param[in]     expected  The beginning of the expected output range
+	@param[in,out] gradient  Gradient matching the shape of the perceptron
+	@param[in,out] workspace Workspace matching the shape of the perceptron
+
+	@returns Loss of the output
+*/
+template<typename T, typename A>
+template<class InputIt1, class InputIt2>
+A MultiLayerPerceptron<T, A>::train(InputIt1 first, InputIt2 expected, Gradient<A>& gradient, TrainingWorkspace<T>& workspace) const {
+	return propagate(first, expected, workspace, [&](std::size_t index, const T* factors, const T* args, T* out) {
+		layers[index].group.modify(factors, args, out, gradient.weights(index), gradient.biases(index));
+	});
+}
+
+/**
+	Adds changes stored in `gradient` to modifications memorized by
+	the perceptron, as if the calls to `train` that produced `gradient`
+	were made without it.
+
+	@param[in] gradient Gradient matching the shape of the perceptron
+*/
+template<typename T, typename A>
+void MultiLayerPerceptron<T, A>::accumulate(const Gradient<A>& gradient) {
+	for (std::size_t i = 0; i < size(); ++i) {
+		MLP_PROFILE_LAYER(accumulate, i, layers[i].group, 1);
+		layers[i].group.accumulate(gradient.weights(i), gradient.biases(i));
+	}
 }
 
 /**
 	@param[in] rate     Learning rate
 	@param[in] momentum Momentum
 */
-template<typename T>
-void MultiLayerPerceptron<T>::apply(T rate, T momentum) {
-	for (auto&& layer : layers) {
-		layer.group.apply(rate, momentum);
+template<typename T, typename A>
+void MultiLayerPerceptron<T, A>::apply(A rate, A momentum) {
+	for (std::size_t i = 0; i < size(); ++i) {
+		MLP_PROFILE_LAYER(apply, i, layers[i].group, 1);
+		layers[i].group.apply(rate, momentum);
 	}
 }
 
@@ -220,11 +460,11 @@ void MultiLayerPerceptron<T>::apply(T rate, T momentum) {
 	                     be assigned to a variable of type `T`
 	@param[in] gen       The generator function
 */
-template<typename T>
+template<typename T, typename A>
 template<class Generator>
-void MultiLayerPerceptron<T>::generateBiases(Generator gen) {
+void MultiLayerPerceptron<T, A>::generateBiases(Generator gen) {
 	for (auto&& layer : layers) {
-		layer.group.generateBiases(gen);
+		layer.group.generateBiases(std::ref(gen));
 	}
 }
 
@@ -237,24 +477,92 @@ void MultiLayerPerceptron<T>::generateBiases(Generator gen) {
 	                     be assigned to a variable of type `T`
 	@param[in] gen       The generator function
 */
-template<typename T>
+template<typename T, typename A>
 template<class Generator>
-void MultiLayerPerceptron<T>::generateWeights(Generator gen) {
+void MultiLayerPerceptron<T, A>::generateWeights(Generator gen) {
 	for (auto&& layer : layers) {
-		layer.group.generateWeights(gen);
+		layer.group.generateWeights(std::ref(gen));
 	}
 }
 
-template<typename T>
+template<typename T, typename A>
 template<class InputIt>
-void MultiLayerPerceptron<T>::construct(std::size_t inputSize, InputIt first, InputIt last) {
-	this->inputSize = inputSize;
+void MultiLayerPerceptron<T, A>::construct(std::size_t inputSize, InputIt first, InputIt last) {
+	inSize = inputSize;
 	std::for_each(first, last, [&](const NeuronLayerSpecification<T>& spec) {
-		layers.emplace_back(NeuronLayer<T>{NeuronGroup<T>(spec.size, inputSize), spec.activation});
+		layers.emplace_back(NeuronLayer<T, A>{NeuronGroup<T, A>(spec.size, inputSize), spec.activation});
 		inputSize = spec.size;
 	});
 }
 
+template<typename T, typename A>
+template<class InputIt>
+const T* MultiLayerPerceptron<T, A>::forward(InputIt first, std::size_t count, InferenceContext<T>& context) const {
+	context.reserve(width(), count);
+	const T* input;
+	if constexpr (isPointerTo<InputIt, T>) {
+		input = first;
+	} else {
+		std::copy_n(first, count * inSize, context.back());
+		input = context.back();
+	}
+	for (std::size_t i = 0; i < size(); ++i) {
+		const NeuronLayer<T, A>& layer = layers[i];
+		T* output = context.front();
+		{
+			MLP_PROFILE_LAYER(forward, i, layer.group, count);
+			if (count == 1) {
+				layer.group.process(input, output);
+			} else {
+				layer.group.processBatch(input, count, output);
+			}
+		}
+		{
+			MLP_PROFILE_LAYER(activation, i, layer.group, count);
+			layer.activation.applyBatch(output, count, layer.group.size(), output);
+		}
+		context.swap();
+		input = output;
+	}
+	return input;
+}
+
+template<typename T, typename A>
+template<class InputIt1, class InputIt2, class Modify>
+A MultiLayerPerceptron<T, A>::propagate(InputIt1 first, InputIt2 expected, TrainingWorkspace<T>& workspace, Modify modify) const {
+	std::copy_n(first, inSize, workspace.activations(0));
+	for (std::size_t i = 0; i < size(); ++i) {
+		const NeuronLayer<T, A>& layer = layers[i];
+		const std::size_t layerSize = layer.group.size();
+		T* sums = workspace.sums(i);
+		{
+			MLP_PROFILE_LAYER(forward, i, layer.group, 1);
+			layer.group.process(workspace.activations(i), sums);
+		}
+		{
+			MLP_PROFILE_LAYER(activation, i, layer.group, 1);
+			layer.activation.apply(sums, layerSize, workspace.activations(i + 1));
+		}
+	}
+	T* factors = workspace.errors(size());
+	const ActivationId outputActivation = layers.empty() ? ActivationId::identity : layers.back().activation.id();
+	A result = evaluateLoss<A>(lossId, outputActivation, workspace.activations(size()), expected, outputSize(), factors);
+	for (std::size_t i = size(); i--;) {
+		const NeuronLayer<T, A>& layer = layers[i];
+		const std::size_t layerSize = layer.group.size();
+		const T* sums = workspace.sums(i);
+		MLP_PROFILE_LAYER(backward, i, layer.group, 1);
+		if (i + 1 != size() || lossId == LossId::squaredError) {
+			layer.activation.applyDerivative(sums, workspace.activations(i + 1), layerSize, factors);
+		}
+		T* buffer = workspace.errors(i);
+		std::fill_n(buffer, layer.group.inputSize(), T());
+		modify(i, factors, workspace.activations(i), buffer);
+		factors = buffer;
+	}
+	return result;
+}
+
 }
 
 #endif
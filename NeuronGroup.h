@@ -27,42 +27,72 @@
 
 #include <algorithm>
 #include <cstddef>
-#include <functional>
-#include <vector>
-#include "Neuron.h"
+#include <iterator>
+#include "AlignedAllocator.h"
+#include "Kernels.h"
+#include "PointerTraits.h"
 
 namespace mlp {
 
 /// Template class representing a group of neurons
 /**
-	A neuron group stores some number of neurons, as well as an activation
-	function used collectively for all of them.
+	A neuron group stores weights of all of its neurons in a single
+	contiguous row-major matrix, where row `i` holds the weights of neuron
+	`i`, along with a vector of biases. Modifications determined by `modify`
+	are accumulated in a matrix and a vector of the same shapes. All four
+	are cache-line aligned, so that processing the group reduces to
+	matrix-vector kernels.
 
 	@tparam T Must meet the requirements of `NumericType` and for objects
 	          `a, b` of type `T`, the expressions `a + b` and `a * b` must
 	          be well-formed and be of type assignable to T.
+	@tparam A Type in which changes to weights and biases are accumulated;
+	          `T` or a wider type, such as `double` for `float` weights
 */
-template<typename T>
+template<typename T, typename A = T>
 class NeuronGroup {
 public:
 	/// Data type the class operates on
 	using ValueType = T;
-	/// Neuron type
-	using Neuron = Neuron<T>;
+	/// Data type changes are accumulated in
+	using AccumulatorType = A;
 	/// Constructs the neuron layer
 	NeuronGroup(std::size_t size, std::size_t inputSize);
 	/// Obtains number of neurons in the layer
 	std::size_t size() const;
 	/// Obtains size of layer input
 	std::size_t inputSize() const;
+	/// Obtains the row-major weight matrix
+	T* weightData();
+	/// Obtains the row-major weight matrix
+	const T* weightData() const;
+	/// Obtains the bias vector
+	T* biasData();
+	/// Obtains the bias vector
+	const T* biasData() const;
+	/// Obtains the row-major matrix of memorized weight changes
+	A* weightChangeData();
+	/// Obtains the row-major matrix of memorized weight changes
+	const A* weightChangeData() const;
+	/// Obtains the vector of memorized bias changes
+	A* biasChangeData();
+	/// Obtains the vector of memorized bias changes
+	const A* biasChangeData() const;
 	/// Produces output based on provided input data
 	template<class ForwardIt, class OutputIt>
 	void process(ForwardIt first, OutputIt out) const;
+	/// Produces output for a batch of contiguous inputs
+	void processBatch(const T* first, std::size_t count, T* out) const;
 	/// Determines changes to biases and weights
 	template<class InputIt, class ForwardIt1, class ForwardIt2>
 	void modify(InputIt factors, ForwardIt1 args, ForwardIt2 out);
+	/// Determines changes to biases and weights and stores them externally
+	template<class InputIt, class ForwardIt1, class ForwardIt2>
+	void modify(InputIt factors, ForwardIt1 args, ForwardIt2 out, A* weightChanges, A* biasChanges) const;
+	/// Adds externally determined changes to biases and weights
+	void accumulate(const A* weightChanges, const A* biasChanges);
 	/// Applies changes to biases and weights
-	void apply(T rate, T momentum);
+	void apply(A rate, A momentum);
 	/// Generates biases of neurons
 	template<class Generator>
 	void generateBiases(Generator gen);
@@ -70,58 +100,161 @@ public:
 	template<class Generator>
 	void generateWeights(Generator gen);
 private:
+	template<class InputIt>
+	void modifyContiguous(InputIt factors, const T* args, T* out, A* weightChanges, A* biasChanges) const;
 	std::size_t inSize;
-	std::vector<Neuron> neurons;
+	std::size_t outSize;
+	AlignedVector<T> weights;
+	AlignedVector<T> biases;
+	AlignedVector<A> weightDiffs;
+	AlignedVector<A> biasDiffs;
 };
 
 /**
-	@tparam    Function   An invokable type with signature equivalent to
-	                      `Ret f(Arg)`, such that a value of type `Ret` may
-	                      be assigned to a variable of type `T` and `T` is
-	                      implicitly convertible to `Arg`
+	Constructs the group. Biases and all weight values are initialized
+	to the default value of T.
+
 	@param[in] size       Number of neurons in the layer
 	@param[in] inputSize  Number of inputs to the layer
 */
-template<typename T>
-NeuronGroup<T>::NeuronGroup(std::size_t size, std::size_t inputSize)
-	: inSize(inputSize), neurons(size, Neuron(inputSize)) {}
+template<typename T, typename A>
+NeuronGroup<T, A>::NeuronGroup(std::size_t size, std::size_t inputSize)
+	: inSize(inputSize), outSize(size), weights(size * inputSize),
+	biases(size), weightDiffs(size * inputSize), biasDiffs(size) {}
 
 /**
 	@returns Size of the layer, i.e. number of neurons it contains
 */
-template<typename T>
-std::size_t NeuronGroup<T>::size() const {
-	return neurons.size();
+template<typename T, typename A>
+std::size_t NeuronGroup<T, A>::size() const {
+	return outSize;
 }
 
 /**
 	@returns Size of the expected input
 */
-template<typename T>
-std::size_t NeuronGroup<T>::inputSize() const {
+template<typename T, typename A>
+std::size_t NeuronGroup<T, A>::inputSize() const {
 	return inSize;
 }
 
+/**
+	@returns Pointer to the first of `size() * inputSize()` weights, where
+	         weight `j` of neuron `i` is at offset `i * inputSize() + j`
+*/
+template<typename T, typename A>
+T* NeuronGroup<T, A>::weightData() {
+	return weights.data();
+}
+
+/**
+	@returns Pointer to the first of `size() * inputSize()` weights, where
+	         weight `j` of neuron `i` is at offset `i * inputSize() + j`
+*/
+template<typename T, typename A>
+const T* NeuronGroup<T, A>::weightData() const {
+	return weights.data();
+}
+
+/**
+	@returns Pointer to the first of `size()` biases
+*/
+template<typename T, typename A>
+T* NeuronGroup<T, A>::biasData() {
+	return biases.data();
+}
+
+/**
+	@returns Pointer to the first of `size()` biases
+*/
+template<typename T, typename A>
+const T* NeuronGroup<T, A>::biasData() const {
+	return biases.data();
+}
+
+/**
+	Changes are laid out like the weights, as described by `weightData`.
+	They may be consumed and cleared by an update rule other than `apply`.
+
+	@returns Pointer to the first of `size() * inputSize()` weight changes
+*/
+template<typename T, typename A>
+A* NeuronGroup<T, A>::weightChangeData() {
+	return weightDiffs.data();
+}
+
+/**
+	@returns Pointer to the first of `size() * inputSize()` weight changes
+*/
+template<typename T, typename A>
+const A* NeuronGroup<T, A>::weightChangeData() const {
+	return weightDiffs.data();
+}
+
+/**
+	@returns Pointer to the first of `size()` bias changes
+*/
+template<typename T, typename A>
+A* NeuronGroup<T, A>::biasChangeData() {
+	return biasDiffs.data();
+}
+
+/**
+	@returns Pointer to the first of `size()` bias changes
+*/
+template<typename T, typename A>
+const A* NeuronGroup<T, A>::biasChangeData() const {
+	return biasDiffs.data();
+}
+
 /**
 	Interprets the range `[first, first + inputSize)` as neuron layer input
-	and forwards it to the neurons. The output is then placed in the range
-	beginning at `out`.
+	and multiplies the weight matrix by it. The output is then placed in the
+	range beginning at `out`. If both iterators are pointers to `T`, the
+	operation is performed in place; otherwise the input is first copied
+	into a contiguous buffer.
 
 	@tparam     ForwardIt Must meet the requirements of `ForwardIterator`
 	@tparam     OutputIt  Must meet the requirements of `OutputIterator`
 	@param[in]  first     The beginning of the input range
 	@param[out] out       The beginning of the destination range
 */
-template<typename T>
+template<typename T, typename A>
 template<class ForwardIt, class OutputIt>
-void NeuronGroup<T>::process(ForwardIt first, OutputIt out) const {
-	using namespace std::placeholders;
-	auto stimulate = &Neuron::template stimulate<ForwardIt>;
-	auto operation = std::bind(stimulate, _1, first);
-	std::transform(neurons.begin(), neurons.end(), out, operation);
+void NeuronGroup<T, A>::process(ForwardIt first, OutputIt out) const {
+	if constexpr (isPointerTo<ForwardIt, T> && isMutablePointerTo<OutputIt, T>) {
+		kernels::gemv(weights.data(), biases.data(), first, outSize, inSize, out);
+	} else {
+		AlignedVector<T> input(inSize);
+		std::copy_n(first, inSize, input.begin());
+		for (std::size_t i = 0; i < outSize; ++i) {
+			*out = biases[i] + kernels::dot(weights.data() + i * inSize, input.data(), inSize);
+			++out;
+		}
+	}
 }
 
 /**
+	Interprets the range `[first, first + count * inputSize)` as `count`
+	consecutive layer inputs and places the respective outputs in the range
+	`[out, out + count * size)`. Equivalent to calling `process` for each
+	input, but reuses every loaded weight across several inputs.
+
+	@param[in]  first The beginning of the input range
+	@param[in]  count Number of inputs
+	@param[out] out   The beginning of the destination range
+*/
+template<typename T, typename A>
+void NeuronGroup<T, A>::processBatch(const T* first, std::size_t count, T* out) const {
+	kernels::gemm(first, count, weights.data(), biases.data(), outSize, inSize, out);
+}
+
+/**
+	Accumulates changes to weights and biases of each neuron based on its
+	common factor and layer input `[args, args + inputSize)`. Adds the
+	product of the transposed weight matrix and the factors to the range
+	`[out, out + inputSize)`.
+
 	@tparam     InputIt    Must meet the requirements of `InputIterator`
 	@tparam     ForwardIt1 Must meet the requirements of `ForwardIterator`
 	@tparam     ForwardIt2 Must meet the requirements of `ForwardIterator`
@@ -129,23 +262,64 @@ void NeuronGroup<T>::process(ForwardIt first, OutputIt out) const {
 	@param[in]  args       The beginning of the input range
 	@param[out] out        The beginning of the output range
 */
-template<typename T>
+template<typename T, typename A>
 template<class InputIt, class ForwardIt1, class ForwardIt2>
-void NeuronGroup<T>::modify(InputIt factors, ForwardIt1 args, ForwardIt2 out) {
-	for (auto&& neuron : neurons) {
-		neuron.nudge(args, *factors, out);
-		++factors;
+void NeuronGroup<T, A>::modify(InputIt factors, ForwardIt1 args, ForwardIt2 out) {
+	modify(factors, args, out, weightDiffs.data(), biasDiffs.data());
+}
+
+/**
+	Behaves like the overload without change pointers, except that changes
+	to weights and biases are accumulated in the row-major matrix beginning
+	at `weightChanges` and the vector beginning at `biasChanges` rather
+	than within the group. The group itself is not modified, so concurrent
+	calls with distinct destinations are safe.
+
+	@tparam     InputIt       Must meet the requirements of `InputIterator`
+	@tparam     ForwardIt1    Must meet the requirements of `ForwardIterator`
+	@tparam     ForwardIt2    Must meet the requirements of `ForwardIterator`
+	@param[in]  factors       Common factors of respective neurons
+	@param[in]  args          The beginning of the input range
+	@param[out] out           The beginning of the output range
+	@param[out] weightChanges The beginning of the weight change matrix
+	@param[out] biasChanges   The beginning of the bias change vector
+*/
+template<typename T, typename A>
+template<class InputIt, class ForwardIt1, class ForwardIt2>
+void NeuronGroup<T, A>::modify(InputIt factors, ForwardIt1 args, ForwardIt2 out, A* weightChanges, A* biasChanges) const {
+	if constexpr (isPointerTo<ForwardIt1, T> && isMutablePointerTo<ForwardIt2, T>) {
+		modifyContiguous(factors, args, out, weightChanges, biasChanges);
+	} else {
+		AlignedVector<T> input(inSize);
+		AlignedVector<T> output(inSize);
+		std::copy_n(args, inSize, input.begin());
+		std::copy_n(out, inSize, output.begin());
+		modifyContiguous(factors, input.data(), output.data(), weightChanges, biasChanges);
+		std::copy(output.begin(), output.end(), out);
 	}
 }
 
+/**
+	Adds the row-major matrix beginning at `weightChanges` and the vector
+	beginning at `biasChanges` to changes accumulated by `modify`.
+
+	@param[in] weightChanges The beginning of the weight change matrix
+	@param[in] biasChanges   The beginning of the bias change vector
+*/
+template<typename T, typename A>
+void NeuronGroup<T, A>::accumulate(const A* weightChanges, const A* biasChanges) {
+	kernels::axpy(A(1), weightChanges, weightDiffs.data(), weightDiffs.size());
+	kernels::axpy(A(1), biasChanges, biasDiffs.data(), biasDiffs.size());
+}
+
 /**
 	@param[in] rate     Learning rate
 	@param[in] momentum Momentum
 */
-template<typename T>
-void NeuronGroup<T>::apply(T rate, T momentum) {
-	using namespace std::placeholders;
-	std::for_each(neurons.begin(), neurons.end(), std::bind(&Neuron::apply, _1, rate, momentum));
+template<typename T, typename A>
+void NeuronGroup<T, A>::apply(A rate, A momentum) {
+	kernels::momentumUpdate(rate, momentum, weights.data(), weightDiffs.data(), weights.size());
+	kernels::momentumUpdate(rate, momentum, biases.data(), biasDiffs.data(), biases.size());
 }
 
 /**
@@ -157,30 +331,37 @@ void NeuronGroup<T>::apply(T rate, T momentum) {
 	                     be assigned to a variable of type `T`
 	@param[in] gen       The generator function
 */
-template<typename T>
+template<typename T, typename A>
 template<class Generator>
-void NeuronGroup<T>::generateBiases(Generator gen) {
-	for (auto&& neuron : neurons) {
-		neuron.setBias(gen());
-	}
+void NeuronGroup<T, A>::generateBiases(Generator gen) {
+	std::generate(biases.begin(), biases.end(), gen);
 }
 
 /**
-	Fills bias and weight values of all neurons in the layer with
-	outputs of function `gen`.
+	Fills weight values of all neurons in the layer with outputs
+	of function `gen`, one neuron after another.
 
 	@tparam    Generator An invokable type with signature equivalent to
 	                     `Ret f()`, such that a value of type `Ret` may
 	                     be assigned to a variable of type `T`
 	@param[in] gen       The generator function
 */
-template<typename T>
+template<typename T, typename A>
 template<class Generator>
-void NeuronGroup<T>::generateWeights(Generator gen) {
-	using namespace std::placeholders;
-	auto generate = &Neuron::template generateWeights<Generator>;
-	auto operation = std::bind(generate, _1, gen);
-	std::for_each(neurons.begin(), neurons.end(), operation);
+void NeuronGroup<T, A>::generateWeights(Generator gen) {
+	std::generate(weights.begin(), weights.end(), gen);
+}
+
+template<typename T, typename A>
+template<class InputIt>
+void NeuronGroup<T, A>::modifyContiguous(InputIt factors, const T* args, T* out, A* weightChanges, A* biasChanges) const {
+	for (std::size_t i = 0; i < outSize; ++i) {
+		T factor = *factors;
+		biasChanges[i] -= A(factor);
+		kernels::axpy(factor, weights.data() + i * inSize, out, inSize);
+		kernels::axpy(A(-factor), args, weightChanges + i * inSize, inSize);
+		++factors;
+	}
 }
 
 }
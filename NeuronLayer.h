@@ -38,13 +38,16 @@ namespace mlp {
 	@tparam T Must meet the requirements of `NumericType` and for objects
 	          `a, b` of type `T`, the expressions `a + b` and `a * b` must
 	          be well-formed and be of type assignable to T.
+	@tparam A Type in which changes to weights and biases are accumulated
 */
-template<typename T>
+template<typename T, typename A = T>
 struct NeuronLayer {
 	/// Data type the class operates on
 	using ValueType = T;
+	/// Data type changes are accumulated in
+	using AccumulatorType = A;
 	/// The group of neurons
-	NeuronGroup<T> group;
+	NeuronGroup<T, A> group;
 	/// The activation function
 	ActivationFunction<T> activation;
 };
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef OPTIMIZER_H_
+#define OPTIMIZER_H_
+
+#include <cmath>
+#include <cstddef>
+#include "AlignedAllocator.h"
+#include "Kernels.h"
+#include "Profiler.h"
+
+namespace mlp {
+
+/// Rules of applying memorized changes to weights and biases
+enum class OptimizerId : unsigned char {
+	/// Gradient descent with classical momentum
+	momentum,
+	/// Gradient descent with Nesterov momentum
+	nesterov,
+	/// Steps scaled by a running root mean square of changes
+	rmsProp,
+	/// Steps of running mean changes scaled by their running root mean square
+	adam,
+};
+
+/// Template class applying memorized changes to a perceptron by a chosen rule
+/**
+	An optimizer replaces `MultiLayerPerceptron::apply` in the training
+	loop. After changes for a batch have been memorized by the perceptron,
+	`apply` consumes them and updates weights and biases according to the
+	rule, using state kept by the optimizer in contiguous buffers that span
+	all parameters of the perceptron, laid out like a `Gradient`. Every
+	rule is a fused kernel making a single pass over the parameters, the
+	changes and the state.
+
+	The momentum rule keeps its velocity in the memorized changes and is
+	exactly `MultiLayerPerceptron::apply`. The Nesterov rule keeps
+	a separate velocity, RMSProp a running mean square of changes, and
+	Adam running means of changes and of their squares, with bias
+	correction. For Adam, the momentum parameter is the decay rate of the
+	mean, usually 0.9.
+
+	@tparam A Type in which changes are accumulated and state is kept
+*/
+template<typename A>
+class Optimizer {
+public:
+	/// Data type the class operates on
+	using ValueType = A;
+	/// Constructs the optimizer with state matching the shape of a perceptron
+	template<class Perceptron>
+	Optimizer(const Perceptron& perceptron, OptimizerId id, A rate, A momentum, A squareDecay, A epsilon);
+	/// Obtains the rule used by the optimizer
+	OptimizerId id() const;
+	/// Applies changes memorized by a perceptron to its weights and biases
+	template<class Perceptron>
+	void apply(Perceptron& perceptron);
+private:
+	template<typename T>
+	void update(T* values, A* changes, std::size_t offset, std::size_t count);
+	OptimizerId identifier;
+	A rate;
+	A momentum;
+	A squareDecay;
+	A epsilon;
+	A stepRate = A();
+	A stepEpsilon = A();
+	std::size_t steps = 0;
+	AlignedVector<A> means;
+	AlignedVector<A> squares;
+};
+
+/**
+	Allocates zeroed state for every weight and bias of `perceptron`, as
+	needed by the rule.
+
+	@tparam    Perceptron  A perceptron type providing `size()` and
+	                       `layer(i)`, such as `MultiLayerPerceptron`
+	@param[in] perceptron  The perceptron whose shape to match
+	@param[in] id          The update rule
+	@param[in] rate        Learning rate
+	@param[in] momentum    Momentum, or decay rate of the mean for Adam
+	@param[in] squareDecay Decay rate of the mean square for RMSProp and
+	                       Adam
+	@param[in] epsilon     Term guarding against division by zero for
+	                       RMSProp and Adam
+*/
+template<typename A>
+template<class Perceptron>
+Optimizer<A>::Optimizer(const Perceptron& perceptron, OptimizerId id, A rate, A momentum, A squareDecay, A epsilon)
+	: identifier(id), rate(rate), momentum(momentum), squareDecay(squareDecay), epsilon(epsilon) {
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < perceptron.size(); ++i) {
+		const auto& group = perceptron.layer(i).group;
+		count += group.size() * group.inputSize() + group.size();
+	}
+	if (id == OptimizerId::nesterov || id == OptimizerId::adam)
+		means.resize(count);
+	if (id == OptimizerId::rmsProp || id == OptimizerId::adam)
+		squares.resize(count);
+}
+
+/**
+	@returns The update rule
+*/
+template<typename A>
+OptimizerId Optimizer<A>::id() const {
+	return identifier;
+}
+
+/**
+	Updates every weight and bias of `perceptron` and clears the memorized
+	changes, except for the momentum rule, which decays them instead.
+
+	@tparam        Perceptron A perceptron type providing `size()`,
+	                          `layer(i)` and `apply(rate, momentum)`,
+	                          such as `MultiLayerPerceptron`
+	@param[in,out] perceptron The perceptron the optimizer was constructed
+	                          for
+*/
+template<typename A>
+template<class Perceptron>
+void Optimizer<A>::apply(Perceptron& perceptron) {
+	if (identifier == OptimizerId::momentum) {
+		perceptron.apply(rate, momentum);
+		return;
+	}
+	++steps;
+	if (identifier == OptimizerId::adam) {
+		const A meanCorrection = 1 - std::pow(momentum, A(steps));
+		const A squareCorrection = std::sqrt(1 - std::pow(squareDecay, A(steps)));
+		stepRate = rate * squareCorrection / meanCorrection;
+		stepEpsilon = epsilon * squareCorrection;
+	}
+	std::size_t offset = 0;
+	for (std::size_t i = 0; i < perceptron.size(); ++i) {
+		auto& group = perceptron.layer(i).group;
+		MLP_PROFILE_LAYER(apply, i, group, 1);
+		const std::size_t weightCount = group.size() * group.inputSize();
+		update(group.weightData(), group.weightChangeData(), offset, weightCount);
+		offset += weightCount;
+		update(group.biasData(), group.biasChangeData(), offset, group.size());
+		offset += group.size();
+	}
+}
+
+template<typename A>
+template<typename T>
+void Optimizer<A>::update(T* values, A* changes, std::size_t offset, std::size_t count) {
+	switch (identifier) {
+	case OptimizerId::nesterov:
+		kernels::nesterovUpdate(rate, momentum, values, changes, means.data() + offset, count);
+		break;
+	case OptimizerId::rmsProp:
+		kernels::rmsPropUpdate(rate, squareDecay, epsilon, values, changes, squares.data() + offset, count);
+		break;
+	case OptimizerId::adam:
+		kernels::adamUpdate(stepRate, momentum, squareDecay, stepEpsilon, values, changes, means.data() + offset, squares.data() + offset, count);
+		break;
+	case OptimizerId::momentum:
+		break;
+	}
+}
+
+}
+
+#endif
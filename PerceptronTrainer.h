@@ -26,12 +26,27 @@
 #define PERCEPTRON_TRAINER_H_
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
 #include <random>
+#include <thread>
 #include <utility>
 #include <vector>
+#include "BatchLoader.h"
+#include "DataSet.h"
+#include "EpochStatistics.h"
+#include "Gradient.h"
+#include "Lbfgs.h"
 #include "MultiLayerPerceptron.h"
+#include "Optimizer.h"
 #include "RandomNumberGenerator.h"
+#include "ThreadPool.h"
+#include "TrainingReport.h"
+#include "TrainingWorkspace.h"
 
 namespace mlp {
 
@@ -46,10 +61,21 @@ public:
 	PerceptronTrainer(std::size_t inputSize, std::size_t outputSize);
 	/// Runs training on a perceptron
 	template<class Perceptron>
-	void train(Perceptron& perceptron) const;
+	TrainingReport train(Perceptron& perceptron) const;
+	/// Runs training on a perceptron using an external data set
+	template<class Perceptron, class Source>
+	TrainingReport train(Perceptron& perceptron, const Source& source) const;
 	/// Adds a new training test case
 	template<class InputIt1, class InputIt2>
 	void addTest(InputIt1 inFirst, InputIt2 outFirst);
+	/// Adds a number of training test cases stored in row-major matrices
+	void addTests(const T* inputs, const T* outputs, std::size_t count);
+	/// Reserves storage for given number of training test cases
+	void reserve(std::size_t count);
+	/// Obtains the training data set
+	DataSet<T>& data() {return dataSet;}
+	/// Obtains the training data set
+	const DataSet<T>& data() const {return dataSet;}
 	/// Sets limit of training iterations
 	void setMaxEpochs(std::size_t value) {maxEpochs = value;}
 	/// Sets acceptable average error upon reaching which the training stops
@@ -58,17 +84,63 @@ public:
 	void setInitialWeightRange(T value) {initialWeightRange = value;}
 	/// Sets learning rate
 	void setLearningRate(T value) {learningRate = value;}
-	/// Sets momentum
+	/// Sets momentum, or decay rate of the mean for Adam
 	void setMomentum(T value) {momentum = value;}
+	/// Sets rule of applying changes to weights and biases
+	void setOptimizer(OptimizerId value) {optimizer = value;}
+	/// Sets decay rate of the mean square of changes for RMSProp and Adam
+	void setSquareDecay(T value) {squareDecay = value;}
+	/// Sets term guarding against division by zero for RMSProp and Adam
+	void setEpsilon(T value) {epsilon = value;}
+	/// Sets method of minimizing the training error
+	void setMethod(TrainingMethod value) {method = value;}
+	/// Sets number of correction pairs kept by L-BFGS
+	void setHistorySize(std::size_t value) {historySize = value;}
+	/// Sets number of tests per weight update; 0 means the whole data set
+	void setBatchSize(std::size_t value) {batchSize = value;}
+	/// Sets number of training threads; 0 means one per hardware thread
+	void setThreadCount(std::size_t value) {threadCount = value;}
+	/// Sets number of consecutive tests shuffled together; 0 means the whole data set
+	void setShuffleWindow(std::size_t value) {shuffleWindow = value;}
+	/// Sets number of batches prepared in advance by a background thread; 0 disables prefetching
+	void setPrefetchCount(std::size_t value) {prefetchCount = value;}
+	/// Sets seed of weight initialization and shuffling; 0 means a different seed for every run
+	void setSeed(std::uint64_t value) {seed = value;}
+	/// Sets function called after every epoch; an empty function disables the calls
+	void setEpochCallback(std::function<void(const EpochStatistics&)> value) {epochCallback = std::move(value);}
+	/// Sets whether epoch statistics include the gradient norm; enabled by default
+	void setGradientNormTracking(bool value) {gradientNormTracking = value;}
 private:
-	std::vector<std::pair<std::vector<T>, std::vector<T>>> dataSet;
-	std::size_t inputSize;
-	std::size_t outputSize;
+	template<class Perceptron>
+	struct TrainingState {
+		using Accumulator = typename Perceptron::AccumulatorType;
+		TrainingState(const Perceptron& perceptron, std::size_t threadCount, bool separateGradients);
+		ThreadPool pool;
+		std::vector<TrainingWorkspace<T>> workspaces;
+		std::vector<Gradient<Accumulator>> gradients;
+		std::vector<Accumulator> errors;
+	};
+	void shuffle(std::vector<std::size_t>& order, std::mt19937_64& engine) const;
+	template<class Perceptron, class Source>
+	typename Perceptron::AccumulatorType trainBatch(Perceptron& perceptron, const Source& source, const std::size_t* first, const std::size_t* last, TrainingState<Perceptron>& state) const;
+	DataSet<T> dataSet;
 	std::size_t maxEpochs = 0;
+	std::size_t batchSize = 0;
+	std::size_t threadCount = 1;
+	std::size_t shuffleWindow = 0;
+	std::size_t prefetchCount = 0;
+	std::size_t historySize = 10;
+	std::uint64_t seed = 0;
 	T errorThreshold = T();
 	T initialWeightRange = T();
 	T learningRate = T();
 	T momentum = T();
+	T squareDecay = T(0.999);
+	T epsilon = T(1e-8);
+	OptimizerId optimizer = OptimizerId::momentum;
+	TrainingMethod method = TrainingMethod::gradientDescent;
+	std::function<void(const EpochStatistics&)> epochCallback;
+	bool gradientNormTracking = true;
 };
 
 /**
@@ -76,42 +148,329 @@ private:
 */
 template<typename T>
 PerceptronTrainer<T>::PerceptronTrainer(std::size_t inputSize, std::size_t outputSize)
-	: inputSize(inputSize), outputSize(outputSize) {}
+	: dataSet(inputSize, outputSize) {}
 
 /**
-	TODO: Detailed description
+	Initializes weights of `perceptron` and runs at most `maxEpochs` epochs
+	of gradient descent over the data set. Each epoch is split into batches
+	of `batchSize` tests, after each of which the accumulated changes are
+	applied; a batch size of 0 or one not smaller than the data set yields
+	full-batch descent, whereas a batch size of 1 yields stochastic gradient
+	descent. Unless the whole data set forms a single batch, the order of
+	tests is shuffled at the beginning of every epoch. Training stops once
+	the average error of an epoch falls below `errorThreshold`. With
+	a nonzero shuffle window, the data set is instead divided into blocks of
+	that many consecutive tests; the order of blocks and the order of tests
+	within each block are shuffled, but every block is traversed as a whole.
+
+	Changes are summed, not averaged, over a batch, so the learning rate
+	should be adjusted when changing the batch size. The error compared
+	with the threshold is the loss selected on the perceptron by
+	`MultiLayerPerceptron::setLoss`, averaged over the tests.
+
+	Changes are applied by an `Optimizer` following the rule set by
+	`setOptimizer`, which defaults to classical momentum. RMSProp and Adam
+	scale every step by a running root mean square of the changes, so their
+	learning rate bounds the size of a step rather than scaling the
+	gradient, and is largely independent of the batch size. Their state is
+	allocated once per call and discarded afterwards.
+
+	With the L-BFGS method set by `setMethod`, every epoch instead computes
+	the error and gradient over the whole data set, takes a search
+	direction from `Lbfgs` and backtracks along it until the error
+	decreases sufficiently, which usually needs a single evaluation. An
+	epoch therefore costs one or more passes over the data set, but small
+	networks converge in far fewer epochs than with gradient descent. The
+	batch size, shuffling, prefetching and the optimizer settings are
+	ignored, and training stops early if no decrease can be found. The
+	error reported for an epoch is that of the weights the epoch ends with,
+	and no epoch is run if the initial weights already meet the threshold.
+
+	Every thread reuses its own training workspace, so training steps
+	perform no allocations. With more than one thread, every batch is split
+	into as many contiguous shards as there are threads. Each shard is
+	backpropagated into its own gradient, and the gradients are then summed
+	pairwise in a fixed tree order before being applied. Results are
+	therefore reproducible for a fixed thread count, but may differ in the
+	last bits between thread counts.
+
+	Weights are drawn and tests are shuffled using pseudo-random sequences
+	seeded with the value set by `setSeed`. With a nonzero seed, training
+	a perceptron of the same topology on the same data set with the same
+	settings and thread count is therefore reproducible, whereas a seed of
+	0 draws a new sequence on every call.
+
+	If an epoch callback is set, it is called after every epoch, including
+	the last one, with the average error, duration and throughput of the
+	epoch and the root mean square norm of its batch gradients. Obtaining
+	the norms requires gradients to be accumulated separately from the
+	perceptron even with a single thread, which costs one pass over the
+	gradient per batch but does not change the results. Disabling
+	`setGradientNormTracking` avoids that cost and reports a norm of 0.
+	Without a callback, the only overhead is reading the clock twice per
+	run.
+
+	@param[in] perceptron The perceptron to train
+
+	@returns Report stating the number of epochs run, the final average
+	         error and whether it fell below the threshold
 */
 template<typename T>
 template<class Perceptron>
-void PerceptronTrainer<T>::train(Perceptron& perceptron) const {
-	double scaledThreshold = errorThreshold * dataSet.size();
-	RandomNumberGenerator<T, std::mt19937_64> generator(-initialWeightRange, initialWeightRange);
-	perceptron.generateWeights(generator);
+TrainingReport PerceptronTrainer<T>::train(Perceptron& perceptron) const {
+	return train(perceptron, dataSet);
+}
+
+/**
+	Behaves like the overload without a data set, except that the tests
+	added to the trainer are ignored and tests of `source` are used instead.
+	The data set is accessed in place, so it may be backed by a mapped file,
+	such as `MappedDataSet`, larger than the available memory. Training on
+	such a data set should use a shuffle window, so that consecutive batches
+	read nearby parts of the file.
+
+	With a nonzero prefetch count, shuffling and gathering of tests is done
+	by a `BatchLoader` on a background thread, which packs each batch into
+	a contiguous buffer while the previous batch is being trained on. The
+	loader draws the order of tests from the same random sequence, so the
+	results are identical to those of training without prefetching with
+	the same seed and thread count.
+
+	@tparam    Source     A data set type providing `size()`, `input(i)` and
+	                      `output(i)`, such as `DataSet` or `MappedDataSet`
+	@param[in] perceptron The perceptron to train
+	@param[in] source     The data set to train on
+
+	@returns Report stating the number of epochs run, the final average
+	         error and whether it fell below the threshold
+*/
+template<typename T>
+template<class Perceptron, class Source>
+TrainingReport PerceptronTrainer<T>::train(Perceptron& perceptron, const Source& source) const {
+	using Accumulator = typename Perceptron::AccumulatorType;
+	double scaledThreshold = errorThreshold * source.size();
+	std::mt19937_64 engine(seed != 0 ? seed : std::random_device{}());
+	if (seed != 0) {
+		perceptron.generateWeights(RandomNumberGenerator<T, std::mt19937_64>(-initialWeightRange, initialWeightRange, engine()));
+	} else {
+		perceptron.generateWeights(RandomNumberGenerator<T, std::mt19937_64>(-initialWeightRange, initialWeightRange));
+	}
+	const std::size_t testCount = source.size();
+	const std::size_t batch = batchSize == 0 ? testCount : std::min(batchSize, testCount);
+	std::vector<std::size_t> order(testCount);
+	std::iota(order.begin(), order.end(), std::size_t());
+	const bool trackGradientNorm = epochCallback && gradientNormTracking;
+	TrainingState<Perceptron> state(perceptron, threadCount == 0 ? std::thread::hardware_concurrency() : threadCount, trackGradientNorm);
+	using Clock = std::chrono::steady_clock;
+	const auto start = Clock::now();
+	auto epochStart = start;
+	TrainingReport report;
+	double squaredNorm = 0.0;
+	std::size_t batches = 0;
+	auto endBatch = [&] {
+		if (trackGradientNorm) {
+			squaredNorm += double(state.gradients.front().squaredNorm());
+			++batches;
+		}
+	};
+	auto endEpoch = [&](Accumulator error) {
+		++report.epochs;
+		report.error = double(error) / testCount;
+		report.converged = error < scaledThreshold;
+		if (epochCallback) {
+			EpochStatistics statistics;
+			statistics.epoch = report.epochs;
+			statistics.error = report.error;
+			statistics.seconds = std::chrono::duration<double>(Clock::now() - epochStart).count();
+			statistics.samplesPerSecond = testCount / statistics.seconds;
+			statistics.gradientNorm = batches == 0 ? 0.0 : std::sqrt(squaredNorm / batches);
+			epochCallback(statistics);
+			squaredNorm = 0.0;
+			batches = 0;
+			epochStart = Clock::now();
+		}
+		return report.converged;
+	};
+	auto finish = [&] {
+		report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		return report;
+	};
+	if (method == TrainingMethod::lbfgs) {
+		if (testCount == 0)
+			return finish();
+		const Accumulator sufficientDecrease = Accumulator(perceptron.loss() == LossId::squaredError ? 2e-4 : 1e-4);
+		const std::size_t maxHalvings = 40;
+		Lbfgs<Accumulator> solver(perceptron, historySize);
+		solver.reset(perceptron);
+		Accumulator error = trainBatch(perceptron, source, order.data(), order.data() + testCount, state);
+		endBatch();
+		report.error = double(error) / testCount;
+		report.converged = error < scaledThreshold;
+		if (report.converged)
+			return finish();
+		for (std::size_t i = maxEpochs; i--;) {
+			const Accumulator slope = solver.search(perceptron);
+			if (!(slope < Accumulator()))
+				return finish();
+			Accumulator step = 1;
+			Accumulator trial = Accumulator();
+			std::size_t halvings = 0;
+			for (; halvings < maxHalvings; step /= 2, ++halvings) {
+				solver.move(perceptron, step);
+				trial = trainBatch(perceptron, source, order.data(), order.data() + testCount, state);
+				endBatch();
+				if (trial <= error + sufficientDecrease * step * slope)
+					break;
+			}
+			if (halvings == maxHalvings) {
+				solver.move(perceptron, Accumulator());
+				if (solver.size() == 0)
+					return finish();
+				solver.reset(perceptron);
+				trial = trainBatch(perceptron, source, order.data(), order.data() + testCount, state);
+				endBatch();
+			}
+			error = trial;
+			if (endEpoch(error))
+				return finish();
+		}
+		return finish();
+	}
+	Optimizer<Accumulator> rule(perceptron, optimizer, Accumulator(learningRate), Accumulator(momentum), Accumulator(squareDecay), Accumulator(epsilon));
+	if (prefetchCount != 0 && testCount != 0) {
+		BatchLoader<T> loader(source, batch, maxEpochs, prefetchCount, [this, batch, testCount, engine](std::vector<std::size_t>& order) mutable {
+			if (batch < testCount)
+				shuffle(order, engine);
+		});
+		Accumulator error = Accumulator();
+		while (const auto* slot = loader.acquire()) {
+			const bool last = slot->lastOfEpoch;
+			error += trainBatch(perceptron, loader.view(*slot), order.data(), order.data() + slot->size, state);
+			loader.release();
+			endBatch();
+			if (last && endEpoch(error))
+				return finish();
+			rule.apply(perceptron);
+			if (last)
+				error = Accumulator();
+		}
+		return finish();
+	}
 	for (std::size_t i = maxEpochs; i--;) {
-		T error = T();
-		for (const auto& test : dataSet) {
-			error += perceptron.train(test.first.begin(), test.second.begin());
+		if (batch < testCount)
+			shuffle(order, engine);
+		Accumulator error = Accumulator();
+		for (std::size_t begin = 0; begin < testCount; begin += batch) {
+			const std::size_t end = std::min(begin + batch, testCount);
+			error += trainBatch(perceptron, source, order.data() + begin, order.data() + end, state);
+			endBatch();
+			if (end == testCount && endEpoch(error))
+				return finish();
+			rule.apply(perceptron);
 		}
-		if (error < scaledThreshold)
-			return;
-		perceptron.apply(learningRate, momentum);
 	}
+	return finish();
 }
 
 /**
-	TODO: Detailed description
+	Copies a test case into the data set, as by `DataSet::addTest`.
+
+	@tparam    InputIt1 Must meet the requirements of `InputIterator`
+	@tparam    InputIt2 Must meet the requirements of `InputIterator`
+	@param[in] inFirst  The beginning of the input range
+	@param[in] outFirst The beginning of the expected output range
 */
 template<typename T>
 template<class InputIt1, class InputIt2>
 void PerceptronTrainer<T>::addTest(InputIt1 inFirst, InputIt2 outFirst) {
-	std::vector<T> in(inputSize);
-	std::copy_n(inFirst, inputSize, in.begin());
-	std::vector<T> out(outputSize);
-	std::copy_n(outFirst, outputSize, out.begin());
-	dataSet.emplace_back(std::move(in), std::move(out));
+	dataSet.addTest(inFirst, outFirst);
 }
 
+/**
+	Copies test cases into the data set, as by `DataSet::addTests`.
+
+	@param[in] inputs  The beginning of the inputs
+	@param[in] outputs The beginning of the expected outputs
+	@param[in] count   Number of test cases
+*/
+template<typename T>
+void PerceptronTrainer<T>::addTests(const T* inputs, const T* outputs, std::size_t count) {
+	dataSet.addTests(inputs, outputs, count);
 }
 
-#endif
+/**
+	@param[in] count Number of test cases
+*/
+template<typename T>
+void PerceptronTrainer<T>::reserve(std::size_t count) {
+	dataSet.reserve(count);
+}
 
+template<typename T>
+template<class Perceptron>
+PerceptronTrainer<T>::TrainingState<Perceptron>::TrainingState(const Perceptron& perceptron, std::size_t threadCount, bool separateGradients)
+	: pool(threadCount), workspaces(pool.size(), TrainingWorkspace<T>(perceptron)), errors(pool.size()) {
+	if (pool.size() > 1 || separateGradients)
+		gradients.assign(pool.size(), Gradient<Accumulator>(perceptron));
+}
+
+template<typename T>
+void PerceptronTrainer<T>::shuffle(std::vector<std::size_t>& order, std::mt19937_64& engine) const {
+	const std::size_t testCount = order.size();
+	if (shuffleWindow == 0 || shuffleWindow >= testCount) {
+		std::shuffle(order.begin(), order.end(), engine);
+		return;
+	}
+	std::vector<std::size_t> blocks((testCount + shuffleWindow - 1) / shuffleWindow);
+	std::iota(blocks.begin(), blocks.end(), std::size_t());
+	std::shuffle(blocks.begin(), blocks.end(), engine);
+	auto out = order.begin();
+	for (std::size_t block : blocks) {
+		const std::size_t begin = block * shuffleWindow;
+		const std::size_t end = std::min(begin + shuffleWindow, testCount);
+		const auto first = out;
+		for (std::size_t i = begin; i < end; ++i)
+			*out++ = i;
+		std::shuffle(first, out, engine);
+	}
+}
+
+template<typename T>
+template<class Perceptron, class Source>
+typename Perceptron::AccumulatorType PerceptronTrainer<T>::trainBatch(Perceptron& perceptron, const Source& source, const std::size_t* first, const std::size_t* last, TrainingState<Perceptron>& state) const {
+	using Accumulator = typename Perceptron::AccumulatorType;
+	if (state.gradients.empty()) {
+		Accumulator error = Accumulator();
+		for (; first != last; ++first) {
+			error += perceptron.train(source.input(*first), source.output(*first), state.workspaces.front());
+		}
+		return error;
+	}
+	const std::size_t count = last - first;
+	const std::size_t shards = state.gradients.size();
+	state.pool.run(shards, [&](std::size_t shard) {
+		auto& gradient = state.gradients[shard];
+		auto& workspace = state.workspaces[shard];
+		gradient.clear();
+		Accumulator error = Accumulator();
+		for (std::size_t i = count * shard / shards; i < count * (shard + 1) / shards; ++i) {
+			error += perceptron.train(source.input(first[i]), source.output(first[i]), gradient, workspace);
+		}
+		state.errors[shard] = error;
+	});
+	for (std::size_t stride = 1; stride < shards; stride *= 2) {
+		state.pool.run((shards + 2 * stride - 1) / (2 * stride), [&](std::size_t pair) {
+			const std::size_t target = 2 * stride * pair;
+			if (target + stride < shards) {
+				state.gradients[target] += state.gradients[target + stride];
+				state.errors[target] += state.errors[target + stride];
+			}
+		});
+	}
+	perceptron.accumulate(state.gradients.front());
+	return state.errors.front();
+}
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef POINTER_TRAITS_H_
+#define POINTER_TRAITS_H_
+
+#include <type_traits>
+
+namespace mlp {
+
+/// Determines whether `It` is a pointer to possibly const-qualified `T`
+/**
+	Iterators satisfying this trait address contiguous storage and may be
+	passed to the kernels directly, without staging through a buffer.
+*/
+template<class It, typename T>
+constexpr bool isPointerTo = std::is_pointer<It>::value
+	&& std::is_same<std::remove_cv_t<std::remove_pointer_t<It>>, T>::value;
+
+/// Determines whether `It` is a pointer to mutable `T`
+template<class It, typename T>
+constexpr bool isMutablePointerTo = isPointerTo<It, T>
+	&& !std::is_const<std::remove_pointer_t<It>>::value;
+
+}
+
+#endif
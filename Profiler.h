@@ -0,0 +1,376 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#ifdef MLP_PROFILING
+#define MLP_PROFILE_LAYER(phase, layer, group, count) \
+	::mlp::ProfileScope mlpProfileScope(::mlp::ProfilePhase::phase, layer, group, count)
+#else
+#define MLP_PROFILE_LAYER(phase, layer, group, count) ((void)0)
+#endif
+
+namespace mlp {
+
+/// Stages of processing a layer measured by the profiler
+enum class ProfilePhase {
+	/// Matrix product of the weights and the input, plus biases
+	forward,
+	/// Application of the activation function
+	activation,
+	/// Backpropagation of errors and computation of changes
+	backward,
+	/// Addition of externally computed changes to memorized ones
+	accumulate,
+	/// Application of memorized changes to weights and biases
+	apply,
+};
+
+/// Structure describing the estimated cost of processing a layer
+struct ProfileCost {
+	/// Number of floating-point operations
+	std::uint64_t flops = 0;
+	/// Number of bytes read and written, assuming no cache reuse
+	std::uint64_t bytes = 0;
+	/// Number of bytes occupied by parameters of the layer and their changes
+	std::uint64_t footprint = 0;
+};
+
+/// Estimates the cost of processing a layer in a given phase
+template<class Group>
+ProfileCost profileCost(ProfilePhase phase, const Group& group, std::size_t count);
+
+/// Class collecting per-layer timings of perceptron hot paths
+/**
+	The profiler aggregates, for every layer index and phase, the number of
+	calls, the total time and the estimated floating-point operations and
+	memory traffic, and keeps a bounded list of individual events for
+	a timeline. Measurements are taken by `MultiLayerPerceptron` only if
+	the library is compiled with `MLP_PROFILING` defined; otherwise the
+	instrumentation compiles to nothing and the profiler stays empty.
+
+	Events from all perceptrons and threads are recorded by a single
+	instance, guarded by a mutex, so the profiler adds tens of nanoseconds
+	to every measured phase. Layers of different perceptrons sharing an
+	index are aggregated together.
+*/
+class Profiler {
+public:
+	/// Type of clock used for measurements
+	using Clock = std::chrono::steady_clock;
+	/// Obtains the global instance
+	static Profiler& instance();
+	/// Records a measured phase of processing a layer
+	void record(ProfilePhase phase, std::size_t layer, Clock::time_point begin, Clock::time_point end, const ProfileCost& cost);
+	/// Discards all measurements and restarts the timeline
+	void reset();
+	/// Sets maximum number of events kept for the timeline
+	void setTraceCapacity(std::size_t value);
+	/// Writes aggregated measurements as JSON
+	void writeJson(std::ostream& out) const;
+	/// Writes recorded events in the Chrome trace event format
+	void writeTrace(std::ostream& out) const;
+private:
+	struct Counter {
+		std::uint64_t calls = 0;
+		std::uint64_t nanoseconds = 0;
+		std::uint64_t flops = 0;
+		std::uint64_t bytes = 0;
+	};
+	struct Layer {
+		std::array<Counter, 5> phases;
+		std::uint64_t footprint = 0;
+	};
+	struct Event {
+		ProfilePhase phase;
+		std::size_t layer;
+		std::size_t thread;
+		std::int64_t begin;
+		std::int64_t duration;
+		ProfileCost cost;
+	};
+	Profiler();
+	static std::size_t threadIndex();
+	static const char* name(ProfilePhase phase);
+	mutable std::mutex mutex;
+	Clock::time_point origin;
+	std::vector<Layer> layers;
+	std::vector<Event> events;
+	std::size_t traceCapacity = std::size_t(1) << 20;
+	std::uint64_t droppedEvents = 0;
+};
+
+/// Class measuring the duration of its own lifetime for the profiler
+class ProfileScope {
+public:
+	/// Starts measuring a phase of processing a layer
+	template<class Group>
+	ProfileScope(ProfilePhase phase, std::size_t layer, const Group& group, std::size_t count);
+	/// Copy constructor (deleted)
+	ProfileScope(const ProfileScope&) = delete;
+	/// Copy assignment operator (deleted)
+	ProfileScope& operator=(const ProfileScope&) = delete;
+	/// Records the measured phase
+	~ProfileScope();
+private:
+	Profiler& profiler;
+	ProfilePhase phase;
+	std::size_t layer;
+	ProfileCost cost;
+	Profiler::Clock::time_point begin;
+};
+
+/**
+	Operation counts follow the kernels used in each phase, counting
+	a multiply-add as two operations and an activation function as one
+	operation per value. Memory traffic counts every parameter, change and
+	value touched once, which is a lower bound if the layer does not fit in
+	the cache and an upper bound otherwise.
+
+	@tparam    Group A neuron group type providing `size()`, `inputSize()`,
+	                 `ValueType` and `AccumulatorType`, such as `NeuronGroup`
+	@param[in] phase Phase to estimate
+	@param[in] group Parameters of the layer
+	@param[in] count Number of processed inputs
+
+	@returns Estimated operation count, memory traffic and footprint
+*/
+template<class Group>
+ProfileCost profileCost(ProfilePhase phase, const Group& group, std::size_t count) {
+	const std::uint64_t value = sizeof(typename Group::ValueType);
+	const std::uint64_t accumulator = sizeof(typename Group::AccumulatorType);
+	const std::uint64_t rows = group.size(), cols = group.inputSize();
+	const std::uint64_t parameters = rows * cols + rows;
+	ProfileCost cost;
+	cost.footprint = parameters * (value + accumulator);
+	switch (phase) {
+	case ProfilePhase::forward:
+		cost.flops = 2 * rows * cols * count;
+		cost.bytes = parameters * value + (rows + cols) * count * value;
+		break;
+	case ProfilePhase::activation:
+		cost.flops = rows * count;
+		cost.bytes = 2 * rows * count * value;
+		break;
+	case ProfilePhase::backward:
+		cost.flops = (4 * rows * cols + 2 * rows) * count;
+		cost.bytes = (rows * cols * value + 2 * parameters * accumulator + (2 * rows + 2 * cols) * value) * count;
+		break;
+	case ProfilePhase::accumulate:
+		cost.flops = parameters;
+		cost.bytes = 3 * parameters * accumulator;
+		break;
+	case ProfilePhase::apply:
+		cost.flops = 3 * parameters;
+		cost.bytes = 2 * parameters * (value + accumulator);
+		break;
+	}
+	return cost;
+}
+
+/**
+	The instance is created on first use, which also starts its timeline.
+
+	@returns Reference to the profiler shared by all perceptrons
+*/
+inline Profiler& Profiler::instance() {
+	static Profiler profiler;
+	return profiler;
+}
+
+/**
+	@param[in] phase  Measured phase
+	@param[in] layer  Index of the layer within its perceptron
+	@param[in] begin  Time the phase started
+	@param[in] end    Time the phase ended
+	@param[in] cost   Estimated cost of the phase
+*/
+inline void Profiler::record(ProfilePhase phase, std::size_t layer, Clock::time_point begin, Clock::time_point end, const ProfileCost& cost) {
+	const std::size_t thread = threadIndex();
+	std::lock_guard<std::mutex> lock(mutex);
+	if (layer >= layers.size()) {
+		layers.resize(layer + 1);
+	}
+	Counter& counter = layers[layer].phases[static_cast<std::size_t>(phase)];
+	const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+	++counter.calls;
+	counter.nanoseconds += duration;
+	counter.flops += cost.flops;
+	counter.bytes += cost.bytes;
+	layers[layer].footprint = cost.footprint;
+	if (events.size() < traceCapacity) {
+		events.push_back({phase, layer, thread, std::chrono::duration_cast<std::chrono::nanoseconds>(begin - origin).count(), duration, cost});
+	} else {
+		++droppedEvents;
+	}
+}
+
+/**
+	Measurements in progress in other threads may be recorded after the
+	reset.
+*/
+inline void Profiler::reset() {
+	std::lock_guard<std::mutex> lock(mutex);
+	layers.clear();
+	events.clear();
+	droppedEvents = 0;
+	origin = Clock::now();
+}
+
+/**
+	Events recorded after the capacity is reached are only aggregated.
+	The default capacity is @f$ 2^{20} @f$ events; 0 disables the timeline.
+
+	@param[in] value Maximum number of events
+*/
+inline void Profiler::setTraceCapacity(std::size_t value) {
+	std::lock_guard<std::mutex> lock(mutex);
+	traceCapacity = value;
+	if (events.size() > traceCapacity) {
+		droppedEvents += events.size() - traceCapacity;
+		events.resize(traceCapacity);
+	}
+}
+
+/**
+	Writes an object holding, for every layer index, the footprint of its
+	parameters and, for every phase, the number of calls, total time,
+	operation and byte counts and the resulting throughput.
+
+	@param[out] out Stream to write to
+*/
+inline void Profiler::writeJson(std::ostream& out) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	out << "{\n\t\"layers\": [";
+	for (std::size_t i = 0; i < layers.size(); ++i) {
+		out << (i == 0 ? "\n" : ",\n");
+		out << "\t\t{\"layer\": " << i << ", \"footprintBytes\": " << layers[i].footprint << ", \"phases\": {";
+		bool first = true;
+		for (std::size_t p = 0; p < layers[i].phases.size(); ++p) {
+			const Counter& counter = layers[i].phases[p];
+			if (counter.calls == 0) {
+				continue;
+			}
+			const double seconds = counter.nanoseconds * 1e-9;
+			out << (first ? "" : ", ") << '"' << name(static_cast<ProfilePhase>(p)) << "\": {"
+				<< "\"calls\": " << counter.calls << ", \"seconds\": " << seconds
+				<< ", \"flops\": " << counter.flops << ", \"bytes\": " << counter.bytes
+				<< ", \"gflopsPerSecond\": " << (seconds > 0 ? counter.flops * 1e-9 / seconds : 0.0)
+				<< ", \"gigabytesPerSecond\": " << (seconds > 0 ? counter.bytes * 1e-9 / seconds : 0.0) << "}";
+			first = false;
+		}
+		out << "}}";
+	}
+	out << "\n\t],\n\t\"droppedEvents\": " << droppedEvents << "\n}\n";
+}
+
+/**
+	Writes every recorded event as a complete event, named after its phase
+	and categorized by its layer, on a track of the thread it ran on. The
+	output can be opened in `chrome://tracing` or Perfetto. Timestamps and
+	durations are written in microseconds with exactly three decimals, so
+	no precision is lost however long the profiler has been running.
+	Scopes still running during `reset` get negative timestamps.
+
+	@param[out] out Stream to write to
+*/
+inline void Profiler::writeTrace(std::ostream& out) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto writeMicroseconds = [&](std::int64_t nanoseconds) {
+		if (nanoseconds < 0) {
+			out << '-';
+			nanoseconds = -nanoseconds;
+		}
+		const std::int64_t fraction = nanoseconds % 1000;
+		out << nanoseconds / 1000 << '.' << char('0' + fraction / 100) << char('0' + fraction / 10 % 10) << char('0' + fraction % 10);
+	};
+	out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+	for (std::size_t i = 0; i < events.size(); ++i) {
+		const Event& event = events[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "{\"name\": \"" << name(event.phase) << "\", \"cat\": \"layer " << event.layer
+			<< "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << event.thread
+			<< ", \"ts\": ";
+		writeMicroseconds(event.begin);
+		out << ", \"dur\": ";
+		writeMicroseconds(event.duration);
+		out << ", \"args\": {\"layer\": " << event.layer << ", \"flops\": " << event.cost.flops
+			<< ", \"bytes\": " << event.cost.bytes << "}}";
+	}
+	out << "\n]}\n";
+}
+
+inline Profiler::Profiler()
+	: origin(Clock::now()) {}
+
+inline std::size_t Profiler::threadIndex() {
+	static std::atomic<std::size_t> next(0);
+	thread_local const std::size_t index = next++;
+	return index;
+}
+
+inline const char* Profiler::name(ProfilePhase phase) {
+	switch (phase) {
+	case ProfilePhase::forward:
+		return "forward";
+	case ProfilePhase::activation:
+		return "activation";
+	case ProfilePhase::backward:
+		return "backward";
+	case ProfilePhase::accumulate:
+		return "accumulate";
+	case ProfilePhase::apply:
+		return "apply";
+	}
+	return "";
+}
+
+/**
+	@tparam    Group A neuron group type accepted by `profileCost`
+	@param[in] phase Measured phase
+	@param[in] layer Index of the layer within its perceptron
+	@param[in] group Parameters of the layer
+	@param[in] count Number of processed inputs
+*/
+template<class Group>
+ProfileScope::ProfileScope(ProfilePhase phase, std::size_t layer, const Group& group, std::size_t count)
+	: profiler(Profiler::instance()), phase(phase), layer(layer), cost(profileCost(phase, group, count)), begin(Profiler::Clock::now()) {}
+
+inline ProfileScope::~ProfileScope() {
+	profiler.record(phase, layer, begin, Profiler::Clock::now(), cost);
+}
+
+}
+
+#endif
@@ -40,8 +40,10 @@ class RandomNumberGenerator {
 public:
 	/// Type of generated numbers
 	using ResultType = T;
-	/// Constructs the generator
+	/// Constructs the generator with a nondeterministic seed
 	RandomNumberGenerator(T min, T max);
+	/// Constructs the generator with a given seed
+	RandomNumberGenerator(T min, T max, typename UnderlyingType::result_type seed);
 	/// Advances state and returns the generated value
 	T operator()();
 private:
@@ -61,6 +63,18 @@ RandomNumberGenerator<T, U>::RandomNumberGenerator(T min, T max)
 	generator.seed(time ^ randomDevice());
 }
 
+/**
+	Generates the same sequence for the same seed, which makes e.g. weight
+	initialization reproducible.
+
+	@param[in] min  Minimum generated value
+	@param[in] max  Maximum generated value
+	@param[in] seed Seed of the underlying generator
+*/
+template<typename T, class U>
+RandomNumberGenerator<T, U>::RandomNumberGenerator(T min, T max, typename U::result_type seed)
+	: distribution(min, max), generator(seed) {}
+
 /**
 	@returns Pseudo-random real number from the range [min, max]
 */
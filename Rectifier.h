@@ -27,7 +27,7 @@
 
 #include <algorithm>
 #include <cmath>
-#include "ActivationFunction.h"
+#include "ActivationId.h"
 
 namespace mlp {
 
@@ -42,10 +42,14 @@ namespace mlp {
 template<typename T>
 class Rectifier {
 public:
+	/// Identifier of the function
+	constexpr static ActivationId id = ActivationId::rectifier;
 	/// Returns rectifier function value
 	constexpr static T f(T x);
 	/// Returns rectifier derivative value
 	constexpr static T df(T x);
+	/// Returns rectifier derivative value expressed by function value
+	constexpr static T dfy(T y);
 };
 
 /**
@@ -72,6 +76,20 @@ constexpr T Rectifier<T>::df(T x) {
 	return std::signbit(x) ? T() : T(1);
 }
 
+/**
+	The result is unspecified if `y == 0` but guaranteed to be within the
+	range `[0, 1]`.
+
+	@param[in] y Function value @f$ y = f(x) @f$
+
+	@returns Derivative value @f$ f^\prime(x) = \begin{cases} 0, & y=0 \\
+	         1, & y>0 \end{cases} @f$
+*/
+template<typename T>
+constexpr T Rectifier<T>::dfy(T y) {
+	return y > T() ? T(1) : T();
+}
+
 }
 
 #endif
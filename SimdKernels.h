@@ -0,0 +1,1193 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef SIMD_KERNELS_H_
+#define SIMD_KERNELS_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(MLP_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define MLP_SIMD
+#endif
+
+#ifdef MLP_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MLP_TARGET(isa)
+#define MLP_ALWAYS_INLINE __forceinline
+#else
+#define MLP_TARGET(isa) __attribute__((target(isa)))
+#define MLP_ALWAYS_INLINE inline __attribute__((always_inline))
+#endif
+#endif
+
+namespace mlp {
+
+namespace kernels {
+
+/// Instruction set extensions used by the kernels
+enum class SimdLevel {
+	/// Portable scalar code only
+	none,
+	/// SSE2, 128-bit vectors
+	sse2,
+	/// AVX2 with FMA, 256-bit vectors
+	avx2,
+	/// AVX-512 Foundation, 512-bit vectors
+	avx512,
+};
+
+/// Obtains the most capable instruction set supported by the processor
+SimdLevel detectSimdLevel();
+/// Obtains the instruction set used by the kernels
+SimdLevel simdLevel();
+/// Limits the instruction set used by the kernels
+void setSimdLevel(SimdLevel level);
+
+/**
+	Queries the processor and operating system once. Always returns
+	`SimdLevel::none` if the library was built with `MLP_NO_SIMD` defined or
+	for targets other than x86-64.
+
+	@returns The most capable supported instruction set
+*/
+inline SimdLevel detectSimdLevel() {
+#ifdef MLP_SIMD
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+	__cpuid(info, 1);
+	const bool sse2 = info[3] & (1 << 26);
+	const bool fma = info[2] & (1 << 12);
+	const bool osxsave = info[2] & (1 << 27);
+	const bool avx = info[2] & (1 << 28);
+	bool avx2 = false, avx512 = false;
+	if (osxsave && avx && maxLeaf >= 7) {
+		const unsigned long long xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		avx2 = fma && (info[1] & (1 << 5)) && (xcr0 & 0x6) == 0x6;
+		avx512 = avx2 && (info[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6;
+	}
+#else
+	__builtin_cpu_init();
+	const bool sse2 = __builtin_cpu_supports("sse2");
+	const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	const bool avx512 = avx2 && __builtin_cpu_supports("avx512f");
+#endif
+	if (avx512)
+		return SimdLevel::avx512;
+	if (avx2)
+		return SimdLevel::avx2;
+	if (sse2)
+		return SimdLevel::sse2;
+#endif
+	return SimdLevel::none;
+}
+
+/// Obtains a reference to the instruction set used by the kernels
+inline SimdLevel& currentSimdLevel() {
+	static SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+/**
+	@returns The instruction set the kernels dispatch to, initially the
+	         result of `detectSimdLevel`
+*/
+inline SimdLevel simdLevel() {
+	return currentSimdLevel();
+}
+
+/**
+	Makes the kernels dispatch to the less capable of `level` and the
+	result of `detectSimdLevel`. Useful for benchmarking and for obtaining
+	results reproducible across machines. Must not be called concurrently
+	with any kernel.
+
+	@param[in] level Most capable instruction set to use
+*/
+inline void setSimdLevel(SimdLevel level) {
+	currentSimdLevel() = level < detectSimdLevel() ? level : detectSimdLevel();
+}
+
+#ifdef MLP_SIMD
+
+/// Determines whether vectorized kernels exist for a type
+template<typename T>
+constexpr bool isVectorizable = false;
+
+/// Vectorized kernels exist for `float`
+template<>
+constexpr bool isVectorizable<float> = true;
+
+/// Vectorized kernels exist for `double`
+template<>
+constexpr bool isVectorizable<double> = true;
+
+/// Loads two consecutive 16-bit values as one 32-bit value
+inline std::int32_t loadPair(const std::int16_t* x) {
+	std::int32_t pair;
+	std::memcpy(&pair, x, sizeof pair);
+	return pair;
+}
+
+/// Kernels using SSE2 instructions
+namespace sse2 {
+
+MLP_TARGET("sse2") MLP_ALWAYS_INLINE double sum(__m128d v) {
+	return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+MLP_TARGET("sse2") MLP_ALWAYS_INLINE float sum(__m128 v) {
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+}
+
+MLP_TARGET("sse2") MLP_ALWAYS_INLINE std::int32_t sum(__m128i v) {
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtsi128_si32(_mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1))));
+}
+
+MLP_TARGET("sse2") inline double dot(const double* x, const double* y, std::size_t n) {
+	__m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+		s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+	}
+	double result = sum(_mm_add_pd(s0, s1));
+	for (; i < n; ++i) {
+		result += x[i] * y[i];
+	}
+	return result;
+}
+
+MLP_TARGET("sse2") inline float dot(const float* x, const float* y, std::size_t n) {
+	__m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+		s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(y + i + 4)));
+	}
+	float result = sum(_mm_add_ps(s0, s1));
+	for (; i < n; ++i) {
+		result += x[i] * y[i];
+	}
+	return result;
+}
+
+MLP_TARGET("sse2") inline void axpy(double a, const double* x, double* y, std::size_t n) {
+	const __m128d va = _mm_set1_pd(a);
+	std::size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		_mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+MLP_TARGET("sse2") inline void axpy(float a, const float* x, float* y, std::size_t n) {
+	const __m128 va = _mm_set1_ps(a);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+MLP_TARGET("sse2") inline void momentumUpdate(double rate, double momentum, double* values, double* diffs, std::size_t n) {
+	const __m128d vr = _mm_set1_pd(rate), vm = _mm_set1_pd(momentum);
+	std::size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		const __m128d d = _mm_loadu_pd(diffs + i);
+		_mm_storeu_pd(values + i, _mm_add_pd(_mm_loadu_pd(values + i), _mm_mul_pd(d, vr)));
+		_mm_storeu_pd(diffs + i, _mm_mul_pd(d, vm));
+	}
+	for (; i < n; ++i) {
+		values[i] += diffs[i] * rate;
+		diffs[i] *= momentum;
+	}
+}
+
+MLP_TARGET("sse2") inline void momentumUpdate(float rate, float momentum, float* values, float* diffs, std::size_t n) {
+	const __m128 vr = _mm_set1_ps(rate), vm = _mm_set1_ps(momentum);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128 d = _mm_loadu_ps(diffs + i);
+		_mm_storeu_ps(values + i, _mm_add_ps(_mm_loadu_ps(values + i), _mm_mul_ps(d, vr)));
+		_mm_storeu_ps(diffs + i, _mm_mul_ps(d, vm));
+	}
+	for (; i < n; ++i) {
+		values[i] += diffs[i] * rate;
+		diffs[i] *= momentum;
+	}
+}
+
+MLP_TARGET("sse2") inline std::int32_t dot(const std::int8_t* x, const std::int8_t* y, std::size_t n) {
+	__m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128();
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+		s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(a, a), 8), _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8)));
+		s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(a, a), 8), _mm_srai_epi16(_mm_unpackhi_epi8(b, b), 8)));
+	}
+	std::int32_t result = sum(_mm_add_epi32(s0, s1));
+	for (; i < n; ++i) {
+		result += std::int32_t(x[i]) * y[i];
+	}
+	return result;
+}
+
+MLP_TARGET("sse2") MLP_ALWAYS_INLINE void multiplyPair(std::int32_t pair, __m128i panel, __m128i& low, __m128i& high) {
+	const __m128i v = _mm_set1_epi32(pair);
+	low = _mm_add_epi32(low, _mm_madd_epi16(v, _mm_srai_epi16(_mm_unpacklo_epi8(panel, panel), 8)));
+	high = _mm_add_epi32(high, _mm_madd_epi16(v, _mm_srai_epi16(_mm_unpackhi_epi8(panel, panel), 8)));
+}
+
+MLP_TARGET("sse2") inline void gemmTile(const std::int8_t* panel, const std::int16_t* in, std::size_t stride, std::size_t depth, std::size_t count, std::int32_t* acc) {
+	const std::size_t even = depth & ~std::size_t(1);
+	for (std::size_t c = 0; c < count; c += 2) {
+		const std::int16_t* x = in + c * stride;
+		const std::int16_t* y = c + 1 < count ? x + stride : x;
+		__m128i a0 = _mm_setzero_si128(), a1 = _mm_setzero_si128(), a2 = _mm_setzero_si128(), a3 = _mm_setzero_si128();
+		for (std::size_t k = 0; k < even; k += 2) {
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(panel + 8 * k));
+			multiplyPair(loadPair(x + k), p, a0, a1);
+			multiplyPair(loadPair(y + k), p, a2, a3);
+		}
+		if (even != depth) {
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(panel + 8 * even));
+			multiplyPair(std::uint16_t(x[even]), p, a0, a1);
+			multiplyPair(std::uint16_t(y[even]), p, a2, a3);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 8 * c), a0);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 8 * c + 4), a1);
+		if (c + 1 < count) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 8 * c + 8), a2);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 8 * c + 12), a3);
+		}
+	}
+}
+
+}
+
+/// Kernels using AVX2 and FMA instructions
+namespace avx2 {
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE double sum(__m256d v) {
+	return sse2::sum(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE float sum(__m256 v) {
+	return sse2::sum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE std::int32_t sum(__m256i v) {
+	return sse2::sum(_mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+}
+
+MLP_TARGET("avx2,fma") inline double dot(const double* x, const double* y, std::size_t n) {
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	__m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+		s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), s1);
+		s2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), s2);
+		s3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), s3);
+	}
+	for (; i + 4 <= n; i += 4) {
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+	}
+	double result = sum(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+	for (; i < n; ++i) {
+		result += x[i] * y[i];
+	}
+	return result;
+}
+
+MLP_TARGET("avx2,fma") inline float dot(const float* x, const float* y, std::size_t n) {
+	__m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+	__m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+	std::size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+		s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), s1);
+		s2 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 16), _mm256_loadu_ps(y + i + 16), s2);
+		s3 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 24), _mm256_loadu_ps(y + i + 24), s3);
+	}
+	for (; i + 8 <= n; i += 8) {
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+	}
+	float result = sum(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+	for (; i < n; ++i) {
+		result += x[i] * y[i];
+	}
+	return result;
+}
+
+MLP_TARGET("avx2,fma") inline void axpy(double a, const double* x, double* y, std::size_t n) {
+	const __m256d va = _mm256_set1_pd(a);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void axpy(float a, const float* x, float* y, std::size_t n) {
+	const __m256 va = _mm256_set1_ps(a);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void momentumUpdate(double rate, double momentum, double* values, double* diffs, std::size_t n) {
+	const __m256d vr = _mm256_set1_pd(rate), vm = _mm256_set1_pd(momentum);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m256d d = _mm256_loadu_pd(diffs + i);
+		_mm256_storeu_pd(values + i, _mm256_fmadd_pd(d, vr, _mm256_loadu_pd(values + i)));
+		_mm256_storeu_pd(diffs + i, _mm256_mul_pd(d, vm));
+	}
+	for (; i < n; ++i) {
+		values[i] += diffs[i] * rate;
+		diffs[i] *= momentum;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void momentumUpdate(float rate, float momentum, float* values, float* diffs, std::size_t n) {
+	const __m256 vr = _mm256_set1_ps(rate), vm = _mm256_set1_ps(momentum);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 d = _mm256_loadu_ps(diffs + i);
+		_mm256_storeu_ps(values + i, _mm256_fmadd_ps(d, vr, _mm256_loadu_ps(values + i)));
+		_mm256_storeu_ps(diffs + i, _mm256_mul_ps(d, vm));
+	}
+	for (; i < n; ++i) {
+		values[i] += diffs[i] * rate;
+		diffs[i] *= momentum;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void axpy(double a, const float* x, double* y, std::size_t n) {
+	const __m256d va = _mm256_set1_pd(a);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 v = _mm256_loadu_ps(x + i);
+		_mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_cvtps_pd(_mm256_castps256_ps128(v)), _mm256_loadu_pd(y + i)));
+		_mm256_storeu_pd(y + i + 4, _mm256_fmadd_pd(va, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), _mm256_loadu_pd(y + i + 4)));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * double(x[i]);
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void momentumUpdate(double rate, double momentum, float* values, double* diffs, std::size_t n) {
+	const __m256d vr = _mm256_set1_pd(rate), vm = _mm256_set1_pd(momentum);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m256d d = _mm256_loadu_pd(diffs + i);
+		const __m256d v = _mm256_cvtps_pd(_mm_loadu_ps(values + i));
+		_mm_storeu_ps(values + i, _mm256_cvtpd_ps(_mm256_fmadd_pd(d, vr, v)));
+		_mm256_storeu_pd(diffs + i, _mm256_mul_pd(d, vm));
+	}
+	for (; i < n; ++i) {
+		values[i] = float(values[i] + diffs[i] * rate);
+		diffs[i] *= momentum;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void nesterovUpdate(double rate, double momentum, double* values, double* changes, double* velocities, std::size_t n) {
+	const __m256d vr = _mm256_set1_pd(rate), vm = _mm256_set1_pd(momentum);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m256d g = _mm256_loadu_pd(changes + i);
+		const __m256d v = _mm256_fmadd_pd(vm, _mm256_loadu_pd(velocities + i), g);
+		_mm256_storeu_pd(velocities + i, v);
+		_mm256_storeu_pd(values + i, _mm256_fmadd_pd(vr, _mm256_fmadd_pd(vm, v, g), _mm256_loadu_pd(values + i)));
+		_mm256_storeu_pd(changes + i, _mm256_setzero_pd());
+	}
+	for (; i < n; ++i) {
+		const double g = changes[i];
+		velocities[i] = momentum * velocities[i] + g;
+		values[i] += rate * (g + momentum * velocities[i]);
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void nesterovUpdate(float rate, float momentum, float* values, float* changes, float* velocities, std::size_t n) {
+	const __m256 vr = _mm256_set1_ps(rate), vm = _mm256_set1_ps(momentum);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 g = _mm256_loadu_ps(changes + i);
+		const __m256 v = _mm256_fmadd_ps(vm, _mm256_loadu_ps(velocities + i), g);
+		_mm256_storeu_ps(velocities + i, v);
+		_mm256_storeu_ps(values + i, _mm256_fmadd_ps(vr, _mm256_fmadd_ps(vm, v, g), _mm256_loadu_ps(values + i)));
+		_mm256_storeu_ps(changes + i, _mm256_setzero_ps());
+	}
+	for (; i < n; ++i) {
+		const float g = changes[i];
+		velocities[i] = momentum * velocities[i] + g;
+		values[i] += rate * (g + momentum * velocities[i]);
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void nesterovUpdate(double rate, double momentum, float* values, double* changes, double* velocities, std::size_t n) {
+	const __m256d vr = _mm256_set1_pd(rate), vm = _mm256_set1_pd(momentum);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m256d g = _mm256_loadu_pd(changes + i);
+		const __m256d v = _mm256_fmadd_pd(vm, _mm256_loadu_pd(velocities + i), g);
+		_mm256_storeu_pd(velocities + i, v);
+		_mm_storeu_ps(values + i, _mm256_cvtpd_ps(_mm256_fmadd_pd(vr, _mm256_fmadd_pd(vm, v, g), _mm256_cvtps_pd(_mm_loadu_ps(values + i)))));
+		_mm256_storeu_pd(changes + i, _mm256_setzero_pd());
+	}
+	for (; i < n; ++i) {
+		const double g = changes[i];
+		velocities[i] = momentum * velocities[i] + g;
+		values[i] = float(values[i] + rate * (g + momentum * velocities[i]));
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void rmsPropUpdate(double rate, double decay, double epsilon, double* values, double* changes, double* squares, std::size_t n) {
+	const __m256d vr = _mm256_set1_pd(rate), vd = _mm256_set1_pd(decay), vc = _mm256_set1_pd(1 - decay), ve = _mm256_set1_pd(epsilon);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m256d g = _mm256_loadu_pd(changes + i);
+		const __m256d q = _mm256_fmadd_pd(vd, _mm256_loadu_pd(squares + i), _mm256_mul_pd(vc, _mm256_mul_pd(g, g)));
+		_mm256_storeu_pd(squares + i, q);
+		_mm256_storeu_pd(values + i, _mm256_fmadd_pd(vr, _mm256_div_pd(g, _mm256_add_pd(_mm256_sqrt_pd(q), ve)), _mm256_loadu_pd(values + i)));
+		_mm256_storeu_pd(changes + i, _mm256_setzero_pd());
+	}
+	for (; i < n; ++i) {
+		const double g = changes[i];
+		squares[i] = decay * squares[i] + (1 - decay) * (g * g);
+		values[i] += rate * (g / (std::sqrt(squares[i]) + epsilon));
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void rmsPropUpdate(float rate, float decay, float epsilon, float* values, float* changes, float* squares, std::size_t n) {
+	const __m256 vr = _mm256_set1_ps(rate), vd = _mm256_set1_ps(decay), vc = _mm256_set1_ps(1 - decay), ve = _mm256_set1_ps(epsilon);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 g = _mm256_loadu_ps(changes + i);
+		const __m256 q = _mm256_fmadd_ps(vd, _mm256_loadu_ps(squares + i), _mm256_mul_ps(vc, _mm256_mul_ps(g, g)));
+		_mm256_storeu_ps(squares + i, q);
+		_mm256_storeu_ps(values + i, _mm256_fmadd_ps(vr, _mm256_div_ps(g, _mm256_add_ps(_mm256_sqrt_ps(q), ve)), _mm256_loadu_ps(values + i)));
+		_mm256_storeu_ps(changes + i, _mm256_setzero_ps());
+	}
+	for (; i < n; ++i) {
+		const float g = changes[i];
+		squares[i] = decay * squares[i] + (1 - decay) * (g * g);
+		values[i] += rate * (g / (std::sqrt(squares[i]) + epsilon));
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void rmsPropUpdate(double rate, double decay, double epsilon, float* values, double* changes, double* squares, std::size_t n) {
+	const __m256d vr = _mm256_set1_pd(rate), vd = _mm256_set1_pd(decay), vc = _mm256_set1_pd(1 - decay), ve = _mm256_set1_pd(epsilon);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m256d g = _mm256_loadu_pd(changes + i);
+		const __m256d q = _mm256_fmadd_pd(vd, _mm256_loadu_pd(squares + i), _mm256_mul_pd(vc, _mm256_mul_pd(g, g)));
+		_mm256_storeu_pd(squares + i, q);
+		_mm_storeu_ps(values + i, _mm256_cvtpd_ps(_mm256_fmadd_pd(vr, _mm256_div_pd(g, _mm256_add_pd(_mm256_sqrt_pd(q), ve)), _mm256_cvtps_pd(_mm_loadu_ps(values + i)))));
+		_mm256_storeu_pd(changes + i, _mm256_setzero_pd());
+	}
+	for (; i < n; ++i) {
+		const double g = changes[i];
+		squares[i] = decay * squares[i] + (1 - decay) * (g * g);
+		values[i] = float(values[i] + rate * (g / (std::sqrt(squares[i]) + epsilon)));
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void adamUpdate(double rate, double decay1, double decay2, double epsilon, double* values, double* changes, double* moments, double* squares, std::size_t n) {
+	const __m256d vr = _mm256_set1_pd(rate), ve = _mm256_set1_pd(epsilon);
+	const __m256d vd1 = _mm256_set1_pd(decay1), vc1 = _mm256_set1_pd(1 - decay1);
+	const __m256d vd2 = _mm256_set1_pd(decay2), vc2 = _mm256_set1_pd(1 - decay2);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m256d g = _mm256_loadu_pd(changes + i);
+		const __m256d m = _mm256_fmadd_pd(vd1, _mm256_loadu_pd(moments + i), _mm256_mul_pd(vc1, g));
+		const __m256d q = _mm256_fmadd_pd(vd2, _mm256_loadu_pd(squares + i), _mm256_mul_pd(vc2, _mm256_mul_pd(g, g)));
+		_mm256_storeu_pd(moments + i, m);
+		_mm256_storeu_pd(squares + i, q);
+		_mm256_storeu_pd(values + i, _mm256_fmadd_pd(vr, _mm256_div_pd(m, _mm256_add_pd(_mm256_sqrt_pd(q), ve)), _mm256_loadu_pd(values + i)));
+		_mm256_storeu_pd(changes + i, _mm256_setzero_pd());
+	}
+	for (; i < n; ++i) {
+		const double g = changes[i];
+		moments[i] = decay1 * moments[i] + (1 - decay1) * g;
+		squares[i] = decay2 * squares[i] + (1 - decay2) * (g * g);
+		values[i] += rate * (moments[i] / (std::sqrt(squares[i]) + epsilon));
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void adamUpdate(float rate, float decay1, float decay2, float epsilon, float* values, float* changes, float* moments, float* squares, std::size_t n) {
+	const __m256 vr = _mm256_set1_ps(rate), ve = _mm256_set1_ps(epsilon);
+	const __m256 vd1 = _mm256_set1_ps(decay1), vc1 = _mm256_set1_ps(1 - decay1);
+	const __m256 vd2 = _mm256_set1_ps(decay2), vc2 = _mm256_set1_ps(1 - decay2);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 g = _mm256_loadu_ps(changes + i);
+		const __m256 m = _mm256_fmadd_ps(vd1, _mm256_loadu_ps(moments + i), _mm256_mul_ps(vc1, g));
+		const __m256 q = _mm256_fmadd_ps(vd2, _mm256_loadu_ps(squares + i), _mm256_mul_ps(vc2, _mm256_mul_ps(g, g)));
+		_mm256_storeu_ps(moments + i, m);
+		_mm256_storeu_ps(squares + i, q);
+		_mm256_storeu_ps(values + i, _mm256_fmadd_ps(vr, _mm256_div_ps(m, _mm256_add_ps(_mm256_sqrt_ps(q), ve)), _mm256_loadu_ps(values + i)));
+		_mm256_storeu_ps(changes + i, _mm256_setzero_ps());
+	}
+	for (; i < n; ++i) {
+		const float g = changes[i];
+		moments[i] = decay1 * moments[i] + (1 - decay1) * g;
+		squares[i] = decay2 * squares[i] + (1 - decay2) * (g * g);
+		values[i] += rate * (moments[i] / (std::sqrt(squares[i]) + epsilon));
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void adamUpdate(double rate, double decay1, double decay2, double epsilon, float* values, double* changes, double* moments, double* squares, std::size_t n) {
+	const __m256d vr = _mm256_set1_pd(rate), ve = _mm256_set1_pd(epsilon);
+	const __m256d vd1 = _mm256_set1_pd(decay1), vc1 = _mm256_set1_pd(1 - decay1);
+	const __m256d vd2 = _mm256_set1_pd(decay2), vc2 = _mm256_set1_pd(1 - decay2);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m256d g = _mm256_loadu_pd(changes + i);
+		const __m256d m = _mm256_fmadd_pd(vd1, _mm256_loadu_pd(moments + i), _mm256_mul_pd(vc1, g));
+		const __m256d q = _mm256_fmadd_pd(vd2, _mm256_loadu_pd(squares + i), _mm256_mul_pd(vc2, _mm256_mul_pd(g, g)));
+		_mm256_storeu_pd(moments + i, m);
+		_mm256_storeu_pd(squares + i, q);
+		_mm_storeu_ps(values + i, _mm256_cvtpd_ps(_mm256_fmadd_pd(vr, _mm256_div_pd(m, _mm256_add_pd(_mm256_sqrt_pd(q), ve)), _mm256_cvtps_pd(_mm_loadu_ps(values + i)))));
+		_mm256_storeu_pd(changes + i, _mm256_setzero_pd());
+	}
+	for (; i < n; ++i) {
+		const double g = changes[i];
+		moments[i] = decay1 * moments[i] + (1 - decay1) * g;
+		squares[i] = decay2 * squares[i] + (1 - decay2) * (g * g);
+		values[i] = float(values[i] + rate * (moments[i] / (std::sqrt(squares[i]) + epsilon)));
+		changes[i] = 0;
+	}
+}
+
+MLP_TARGET("avx2,fma") inline std::int32_t dot(const std::int8_t* x, const std::int8_t* y, std::size_t n) {
+	__m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+	std::size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		const __m256i a0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+		const __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)));
+		const __m256i a1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i + 16)));
+		const __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i + 16)));
+		s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(a0, b0));
+		s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(a1, b1));
+	}
+	for (; i + 16 <= n; i += 16) {
+		const __m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+		const __m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)));
+		s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(a, b));
+	}
+	std::int32_t result = sum(_mm256_add_epi32(s0, s1));
+	for (; i < n; ++i) {
+		result += std::int32_t(x[i]) * y[i];
+	}
+	return result;
+}
+
+MLP_TARGET("avx2,fma") inline void gemmTile(const double* panel, const double* in, std::size_t stride, std::size_t depth, double* acc) {
+	__m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd(), a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+	__m256d a4 = _mm256_setzero_pd(), a5 = _mm256_setzero_pd(), a6 = _mm256_setzero_pd(), a7 = _mm256_setzero_pd();
+	for (std::size_t k = 0; k < depth; ++k) {
+		const __m256d p0 = _mm256_loadu_pd(panel + 8 * k);
+		const __m256d p1 = _mm256_loadu_pd(panel + 8 * k + 4);
+		__m256d v = _mm256_broadcast_sd(in + k);
+		a0 = _mm256_fmadd_pd(v, p0, a0);
+		a1 = _mm256_fmadd_pd(v, p1, a1);
+		v = _mm256_broadcast_sd(in + stride + k);
+		a2 = _mm256_fmadd_pd(v, p0, a2);
+		a3 = _mm256_fmadd_pd(v, p1, a3);
+		v = _mm256_broadcast_sd(in + 2 * stride + k);
+		a4 = _mm256_fmadd_pd(v, p0, a4);
+		a5 = _mm256_fmadd_pd(v, p1, a5);
+		v = _mm256_broadcast_sd(in + 3 * stride + k);
+		a6 = _mm256_fmadd_pd(v, p0, a6);
+		a7 = _mm256_fmadd_pd(v, p1, a7);
+	}
+	_mm256_storeu_pd(acc, a0);
+	_mm256_storeu_pd(acc + 4, a1);
+	_mm256_storeu_pd(acc + 8, a2);
+	_mm256_storeu_pd(acc + 12, a3);
+	_mm256_storeu_pd(acc + 16, a4);
+	_mm256_storeu_pd(acc + 20, a5);
+	_mm256_storeu_pd(acc + 24, a6);
+	_mm256_storeu_pd(acc + 28, a7);
+}
+
+MLP_TARGET("avx2,fma") inline void gemmTile(const float* panel, const float* in, std::size_t stride, std::size_t depth, float* acc) {
+	__m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+	for (std::size_t k = 0; k < depth; ++k) {
+		const __m256 p = _mm256_loadu_ps(panel + 8 * k);
+		a0 = _mm256_fmadd_ps(_mm256_broadcast_ss(in + k), p, a0);
+		a1 = _mm256_fmadd_ps(_mm256_broadcast_ss(in + stride + k), p, a1);
+		a2 = _mm256_fmadd_ps(_mm256_broadcast_ss(in + 2 * stride + k), p, a2);
+		a3 = _mm256_fmadd_ps(_mm256_broadcast_ss(in + 3 * stride + k), p, a3);
+	}
+	_mm256_storeu_ps(acc, a0);
+	_mm256_storeu_ps(acc + 8, a1);
+	_mm256_storeu_ps(acc + 16, a2);
+	_mm256_storeu_ps(acc + 24, a3);
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256i loadPanel(const std::int8_t* panel) {
+	return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(panel)));
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256i multiplyPair(__m256i acc, std::int32_t pair, __m256i panel) {
+	return _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_set1_epi32(pair), panel));
+}
+
+MLP_TARGET("avx2,fma") inline void gemmTile(const std::int8_t* panel, const std::int16_t* in, std::size_t stride, std::size_t depth, std::size_t count, std::int32_t* acc) {
+	const std::size_t even = depth & ~std::size_t(1);
+	if (count == 4) {
+		__m256i a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256(), a2 = _mm256_setzero_si256(), a3 = _mm256_setzero_si256();
+		for (std::size_t k = 0; k < even; k += 2) {
+			const __m256i p = loadPanel(panel + 8 * k);
+			a0 = multiplyPair(a0, loadPair(in + k), p);
+			a1 = multiplyPair(a1, loadPair(in + stride + k), p);
+			a2 = multiplyPair(a2, loadPair(in + 2 * stride + k), p);
+			a3 = multiplyPair(a3, loadPair(in + 3 * stride + k), p);
+		}
+		if (even != depth) {
+			const __m256i p = loadPanel(panel + 8 * even);
+			a0 = multiplyPair(a0, std::uint16_t(in[even]), p);
+			a1 = multiplyPair(a1, std::uint16_t(in[stride + even]), p);
+			a2 = multiplyPair(a2, std::uint16_t(in[2 * stride + even]), p);
+			a3 = multiplyPair(a3, std::uint16_t(in[3 * stride + even]), p);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), a0);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + 8), a1);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + 16), a2);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + 24), a3);
+		return;
+	}
+	for (std::size_t c = 0; c < count; ++c) {
+		const std::int16_t* x = in + c * stride;
+		__m256i a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256();
+		std::size_t k = 0;
+		for (; k + 4 <= depth; k += 4) {
+			a0 = multiplyPair(a0, loadPair(x + k), loadPanel(panel + 8 * k));
+			a1 = multiplyPair(a1, loadPair(x + k + 2), loadPanel(panel + 8 * k + 16));
+		}
+		if (k + 2 <= depth) {
+			a0 = multiplyPair(a0, loadPair(x + k), loadPanel(panel + 8 * k));
+			k += 2;
+		}
+		if (k < depth) {
+			a1 = multiplyPair(a1, std::uint16_t(x[k]), loadPanel(panel + 8 * k));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + 8 * c), _mm256_add_epi32(a0, a1));
+	}
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256 broadcast(float a) {
+	return _mm256_set1_ps(a);
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256d broadcast(double a) {
+	return _mm256_set1_pd(a);
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256i roundQuantized(__m256 v) {
+	v = _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-127.0f)), _mm256_set1_ps(127.0f));
+	return _mm256_cvttps_epi32(_mm256_add_ps(v, _mm256_or_ps(_mm256_set1_ps(0.5f), _mm256_and_ps(v, _mm256_set1_ps(-0.0f)))));
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m128i roundQuantized(__m256d v) {
+	v = _mm256_min_pd(_mm256_max_pd(v, _mm256_set1_pd(-127.0)), _mm256_set1_pd(127.0));
+	return _mm256_cvttpd_epi32(_mm256_add_pd(v, _mm256_or_pd(_mm256_set1_pd(0.5), _mm256_and_pd(v, _mm256_set1_pd(-0.0)))));
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256i quantize8(const float* x, __m256 inverse) {
+	return roundQuantized(_mm256_mul_ps(_mm256_loadu_ps(x), inverse));
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256i quantize8(const double* x, __m256d inverse) {
+	const __m128i low = roundQuantized(_mm256_mul_pd(_mm256_loadu_pd(x), inverse));
+	const __m128i high = roundQuantized(_mm256_mul_pd(_mm256_loadu_pd(x + 4), inverse));
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+template<typename T, typename Q>
+MLP_TARGET("avx2,fma") inline void quantize(const T* x, std::size_t n, T scale, Q* q) {
+	const T inverse = T(1) / scale;
+	const auto factor = broadcast(inverse);
+	std::size_t i = 0;
+	if constexpr (sizeof(Q) == 1) {
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		for (; i + 32 <= n; i += 32) {
+			const __m256i low = _mm256_packs_epi32(quantize8(x + i, factor), quantize8(x + i + 8, factor));
+			const __m256i high = _mm256_packs_epi32(quantize8(x + i + 16, factor), quantize8(x + i + 24, factor));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(q + i), _mm256_permutevar8x32_epi32(_mm256_packs_epi16(low, high), order));
+		}
+	} else {
+		for (; i + 16 <= n; i += 16) {
+			const __m256i packed = _mm256_packs_epi32(quantize8(x + i, factor), quantize8(x + i + 8, factor));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(q + i), _mm256_permute4x64_epi64(packed, 0xD8));
+		}
+	}
+	for (; i < n; ++i) {
+		T v = x[i] * inverse;
+		v = v < T(-127) ? T(-127) : v > T(127) ? T(127) : v;
+		q[i] = static_cast<Q>(v < T() ? v - T(0.5) : v + T(0.5));
+	}
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256d expApprox(__m256d x) {
+	x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-708.0)), _mm256_set1_pd(709.0));
+	const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.44269504088896341)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(6.93145751953125e-1), x);
+	r = _mm256_fnmadd_pd(n, _mm256_set1_pd(1.42860682030941723212e-6), r);
+	__m256d p = _mm256_set1_pd(1.0 / 5040);
+	p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 720));
+	p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 120));
+	p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 24));
+	p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 6));
+	p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(0.5));
+	p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+	p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+	const __m256i e = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1023));
+	return _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(e, 52)));
+}
+
+MLP_TARGET("avx2,fma") MLP_ALWAYS_INLINE __m256 expApprox(__m256 x) {
+	x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.0f)), _mm256_set1_ps(88.0f));
+	const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+	r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+	__m256 p = _mm256_set1_ps(1.0f / 5040);
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 720));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 120));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 24));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f / 6));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(0.5f));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+	p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.0f));
+	const __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+	return _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(e, 23)));
+}
+
+MLP_TARGET("avx2,fma") inline void fastLogistic(const double* x, std::size_t n, double* y) {
+	const __m256d one = _mm256_set1_pd(1.0);
+	alignas(32) double tail[4] = {};
+	for (std::size_t i = 0; i < n; i += 4) {
+		const std::size_t m = n - i < 4 ? n - i : 4;
+		const double* in = x + i;
+		if (m < 4) {
+			for (std::size_t j = 0; j < m; ++j) {
+				tail[j] = x[i + j];
+			}
+			in = tail;
+		}
+		const __m256d e = expApprox(_mm256_sub_pd(_mm256_setzero_pd(), _mm256_loadu_pd(in)));
+		const __m256d v = _mm256_div_pd(one, _mm256_add_pd(one, e));
+		if (m < 4) {
+			_mm256_store_pd(tail, v);
+			for (std::size_t j = 0; j < m; ++j) {
+				y[i + j] = tail[j];
+			}
+		} else {
+			_mm256_storeu_pd(y + i, v);
+		}
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void fastLogistic(const float* x, std::size_t n, float* y) {
+	const __m256 one = _mm256_set1_ps(1.0f);
+	alignas(32) float tail[8] = {};
+	for (std::size_t i = 0; i < n; i += 8) {
+		const std::size_t m = n - i < 8 ? n - i : 8;
+		const float* in = x + i;
+		if (m < 8) {
+			for (std::size_t j = 0; j < m; ++j) {
+				tail[j] = x[i + j];
+			}
+			in = tail;
+		}
+		const __m256 e = expApprox(_mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(in)));
+		const __m256 v = _mm256_div_ps(one, _mm256_add_ps(one, e));
+		if (m < 8) {
+			_mm256_store_ps(tail, v);
+			for (std::size_t j = 0; j < m; ++j) {
+				y[i + j] = tail[j];
+			}
+		} else {
+			_mm256_storeu_ps(y + i, v);
+		}
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void fastTanh(const double* x, std::size_t n, double* y) {
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d two = _mm256_set1_pd(2.0);
+	alignas(32) double tail[4] = {};
+	for (std::size_t i = 0; i < n; i += 4) {
+		const std::size_t m = n - i < 4 ? n - i : 4;
+		const double* in = x + i;
+		if (m < 4) {
+			for (std::size_t j = 0; j < m; ++j) {
+				tail[j] = x[i + j];
+			}
+			in = tail;
+		}
+		const __m256d e = expApprox(_mm256_mul_pd(two, _mm256_loadu_pd(in)));
+		const __m256d v = _mm256_sub_pd(one, _mm256_div_pd(two, _mm256_add_pd(e, one)));
+		if (m < 4) {
+			_mm256_store_pd(tail, v);
+			for (std::size_t j = 0; j < m; ++j) {
+				y[i + j] = tail[j];
+			}
+		} else {
+			_mm256_storeu_pd(y + i, v);
+		}
+	}
+}
+
+MLP_TARGET("avx2,fma") inline void fastTanh(const float* x, std::size_t n, float* y) {
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	alignas(32) float tail[8] = {};
+	for (std::size_t i = 0; i < n; i += 8) {
+		const std::size_t m = n - i < 8 ? n - i : 8;
+		const float* in = x + i;
+		if (m < 8) {
+			for (std::size_t j = 0; j < m; ++j) {
+				tail[j] = x[i + j];
+			}
+			in = tail;
+		}
+		const __m256 e = expApprox(_mm256_mul_ps(two, _mm256_loadu_ps(in)));
+		const __m256 v = _mm256_sub_ps(one, _mm256_div_ps(two, _mm256_add_ps(e, one)));
+		if (m < 8) {
+			_mm256_store_ps(tail, v);
+			for (std::size_t j = 0; j < m; ++j) {
+				y[i + j] = tail[j];
+			}
+		} else {
+			_mm256_storeu_ps(y + i, v);
+		}
+	}
+}
+
+}
+
+/// Kernels using AVX-512 Foundation instructions
+namespace avx512 {
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE double sum(__m512d v) {
+	alignas(64) double lanes[8];
+	_mm512_store_pd(lanes, v);
+	return avx2::sum(_mm256_add_pd(_mm256_load_pd(lanes), _mm256_load_pd(lanes + 4)));
+}
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE float sum(__m512 v) {
+	alignas(64) float lanes[16];
+	_mm512_store_ps(lanes, v);
+	return avx2::sum(_mm256_add_ps(_mm256_load_ps(lanes), _mm256_load_ps(lanes + 8)));
+}
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE __mmask8 tailMask8(std::size_t n) {
+	return static_cast<__mmask8>((1u << n) - 1);
+}
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE __mmask16 tailMask16(std::size_t n) {
+	return static_cast<__mmask16>((1u << n) - 1);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline double dot(const double* x, const double* y, std::size_t n) {
+	__m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+	__m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+	std::size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), s0);
+		s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), s1);
+		s2 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 16), _mm512_loadu_pd(y + i + 16), s2);
+		s3 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 24), _mm512_loadu_pd(y + i + 24), s3);
+	}
+	for (; i + 8 <= n; i += 8) {
+		s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), s0);
+	}
+	if (i < n) {
+		const __mmask8 mask = tailMask8(n - i);
+		s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), s1);
+	}
+	return sum(_mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)));
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline float dot(const float* x, const float* y, std::size_t n) {
+	__m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+	__m512 s2 = _mm512_setzero_ps(), s3 = _mm512_setzero_ps();
+	std::size_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+		s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+		s1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), s1);
+		s2 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 32), _mm512_loadu_ps(y + i + 32), s2);
+		s3 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 48), _mm512_loadu_ps(y + i + 48), s3);
+	}
+	for (; i + 16 <= n; i += 16) {
+		s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+	}
+	if (i < n) {
+		const __mmask16 mask = tailMask16(n - i);
+		s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), s1);
+	}
+	return sum(_mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3)));
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void axpy(double a, const double* x, double* y, std::size_t n) {
+	const __m512d va = _mm512_set1_pd(a);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+	}
+	if (i < n) {
+		const __mmask8 mask = tailMask8(n - i);
+		const __m512d r = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+		_mm512_mask_storeu_pd(y + i, mask, r);
+	}
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void axpy(float a, const float* x, float* y, std::size_t n) {
+	const __m512 va = _mm512_set1_ps(a);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+	}
+	if (i < n) {
+		const __mmask16 mask = tailMask16(n - i);
+		const __m512 r = _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+		_mm512_mask_storeu_ps(y + i, mask, r);
+	}
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void momentumUpdate(double rate, double momentum, double* values, double* diffs, std::size_t n) {
+	const __m512d vr = _mm512_set1_pd(rate), vm = _mm512_set1_pd(momentum);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m512d d = _mm512_loadu_pd(diffs + i);
+		_mm512_storeu_pd(values + i, _mm512_fmadd_pd(d, vr, _mm512_loadu_pd(values + i)));
+		_mm512_storeu_pd(diffs + i, _mm512_mul_pd(d, vm));
+	}
+	if (i < n) {
+		const __mmask8 mask = tailMask8(n - i);
+		const __m512d d = _mm512_maskz_loadu_pd(mask, diffs + i);
+		_mm512_mask_storeu_pd(values + i, mask, _mm512_fmadd_pd(d, vr, _mm512_maskz_loadu_pd(mask, values + i)));
+		_mm512_mask_storeu_pd(diffs + i, mask, _mm512_mul_pd(d, vm));
+	}
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void momentumUpdate(float rate, float momentum, float* values, float* diffs, std::size_t n) {
+	const __m512 vr = _mm512_set1_ps(rate), vm = _mm512_set1_ps(momentum);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m512 d = _mm512_loadu_ps(diffs + i);
+		_mm512_storeu_ps(values + i, _mm512_fmadd_ps(d, vr, _mm512_loadu_ps(values + i)));
+		_mm512_storeu_ps(diffs + i, _mm512_mul_ps(d, vm));
+	}
+	if (i < n) {
+		const __mmask16 mask = tailMask16(n - i);
+		const __m512 d = _mm512_maskz_loadu_ps(mask, diffs + i);
+		_mm512_mask_storeu_ps(values + i, mask, _mm512_fmadd_ps(d, vr, _mm512_maskz_loadu_ps(mask, values + i)));
+		_mm512_mask_storeu_ps(diffs + i, mask, _mm512_mul_ps(d, vm));
+	}
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void axpy(double a, const float* x, double* y, std::size_t n) {
+	avx2::axpy(a, x, y, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void momentumUpdate(double rate, double momentum, float* values, double* diffs, std::size_t n) {
+	avx2::momentumUpdate(rate, momentum, values, diffs, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void nesterovUpdate(double rate, double momentum, double* values, double* changes, double* velocities, std::size_t n) {
+	avx2::nesterovUpdate(rate, momentum, values, changes, velocities, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void nesterovUpdate(float rate, float momentum, float* values, float* changes, float* velocities, std::size_t n) {
+	avx2::nesterovUpdate(rate, momentum, values, changes, velocities, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void nesterovUpdate(double rate, double momentum, float* values, double* changes, double* velocities, std::size_t n) {
+	avx2::nesterovUpdate(rate, momentum, values, changes, velocities, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void rmsPropUpdate(double rate, double decay, double epsilon, double* values, double* changes, double* squares, std::size_t n) {
+	avx2::rmsPropUpdate(rate, decay, epsilon, values, changes, squares, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void rmsPropUpdate(float rate, float decay, float epsilon, float* values, float* changes, float* squares, std::size_t n) {
+	avx2::rmsPropUpdate(rate, decay, epsilon, values, changes, squares, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void rmsPropUpdate(double rate, double decay, double epsilon, float* values, double* changes, double* squares, std::size_t n) {
+	avx2::rmsPropUpdate(rate, decay, epsilon, values, changes, squares, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void adamUpdate(double rate, double decay1, double decay2, double epsilon, double* values, double* changes, double* moments, double* squares, std::size_t n) {
+	avx2::adamUpdate(rate, decay1, decay2, epsilon, values, changes, moments, squares, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void adamUpdate(float rate, float decay1, float decay2, float epsilon, float* values, float* changes, float* moments, float* squares, std::size_t n) {
+	avx2::adamUpdate(rate, decay1, decay2, epsilon, values, changes, moments, squares, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void adamUpdate(double rate, double decay1, double decay2, double epsilon, float* values, double* changes, double* moments, double* squares, std::size_t n) {
+	avx2::adamUpdate(rate, decay1, decay2, epsilon, values, changes, moments, squares, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline std::int32_t dot(const std::int8_t* x, const std::int8_t* y, std::size_t n) {
+	return avx2::dot(x, y, n);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void gemmTile(const double* panel, const double* in, std::size_t stride, std::size_t depth, double* acc) {
+	__m512d a0 = _mm512_setzero_pd(), a1 = _mm512_setzero_pd(), a2 = _mm512_setzero_pd(), a3 = _mm512_setzero_pd();
+	for (std::size_t k = 0; k < depth; ++k) {
+		const __m512d p = _mm512_loadu_pd(panel + 8 * k);
+		a0 = _mm512_fmadd_pd(_mm512_set1_pd(in[k]), p, a0);
+		a1 = _mm512_fmadd_pd(_mm512_set1_pd(in[stride + k]), p, a1);
+		a2 = _mm512_fmadd_pd(_mm512_set1_pd(in[2 * stride + k]), p, a2);
+		a3 = _mm512_fmadd_pd(_mm512_set1_pd(in[3 * stride + k]), p, a3);
+	}
+	_mm512_storeu_pd(acc, a0);
+	_mm512_storeu_pd(acc + 8, a1);
+	_mm512_storeu_pd(acc + 16, a2);
+	_mm512_storeu_pd(acc + 24, a3);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void gemmTile(const float* panel, const float* in, std::size_t stride, std::size_t depth, float* acc) {
+	avx2::gemmTile(panel, in, stride, depth, acc);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void gemmTile(const std::int8_t* panel, const std::int16_t* in, std::size_t stride, std::size_t depth, std::size_t count, std::int32_t* acc) {
+	avx2::gemmTile(panel, in, stride, depth, count, acc);
+}
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE __m512 broadcast(float a) {
+	return _mm512_set1_ps(a);
+}
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE __m512d broadcast(double a) {
+	return _mm512_set1_pd(a);
+}
+
+// The zero-masking forms with all lanes selected are used because the plain
+// forms of these intrinsics make GCC 12 warn about uninitialized variables
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE __m512i roundQuantized(__m512 v) {
+	const __mmask16 all = 0xFFFF;
+	const __m512 half = _mm512_set1_ps(0.5f);
+	v = _mm512_maskz_min_ps(all, _mm512_maskz_max_ps(all, v, _mm512_set1_ps(-127.0f)), _mm512_set1_ps(127.0f));
+	return _mm512_maskz_cvttps_epi32(all, _mm512_mask_sub_ps(_mm512_add_ps(v, half), _mm512_cmp_ps_mask(v, _mm512_setzero_ps(), _CMP_LT_OQ), v, half));
+}
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE __m256i roundQuantized(__m512d v) {
+	const __mmask8 all = 0xFF;
+	const __m512d half = _mm512_set1_pd(0.5);
+	v = _mm512_maskz_min_pd(all, _mm512_maskz_max_pd(all, v, _mm512_set1_pd(-127.0)), _mm512_set1_pd(127.0));
+	return _mm512_maskz_cvttpd_epi32(all, _mm512_mask_sub_pd(_mm512_add_pd(v, half), _mm512_cmp_pd_mask(v, _mm512_setzero_pd(), _CMP_LT_OQ), v, half));
+}
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE __m512i quantize16(const float* x, __m512 inverse) {
+	return roundQuantized(_mm512_mul_ps(_mm512_loadu_ps(x), inverse));
+}
+
+MLP_TARGET("avx512f,avx2,fma") MLP_ALWAYS_INLINE __m512i quantize16(const double* x, __m512d inverse) {
+	const __m256i low = roundQuantized(_mm512_mul_pd(_mm512_loadu_pd(x), inverse));
+	const __m256i high = roundQuantized(_mm512_mul_pd(_mm512_loadu_pd(x + 8), inverse));
+	return _mm512_maskz_inserti64x4(0xFF, _mm512_castsi256_si512(low), high, 1);
+}
+
+template<typename T, typename Q>
+MLP_TARGET("avx512f,avx2,fma") inline void quantize(const T* x, std::size_t n, T scale, Q* q) {
+	const T inverse = T(1) / scale;
+	const auto factor = broadcast(inverse);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m512i values = quantize16(x + i, factor);
+		if constexpr (sizeof(Q) == 1) {
+			_mm512_mask_cvtsepi32_storeu_epi8(q + i, 0xFFFF, values);
+		} else {
+			_mm512_mask_cvtsepi32_storeu_epi16(q + i, 0xFFFF, values);
+		}
+	}
+	for (; i < n; ++i) {
+		T v = x[i] * inverse;
+		v = v < T(-127) ? T(-127) : v > T(127) ? T(127) : v;
+		q[i] = static_cast<Q>(v < T() ? v - T(0.5) : v + T(0.5));
+	}
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void fastLogistic(const double* x, std::size_t n, double* y) {
+	avx2::fastLogistic(x, n, y);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void fastLogistic(const float* x, std::size_t n, float* y) {
+	avx2::fastLogistic(x, n, y);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void fastTanh(const double* x, std::size_t n, double* y) {
+	avx2::fastTanh(x, n, y);
+}
+
+MLP_TARGET("avx512f,avx2,fma") inline void fastTanh(const float* x, std::size_t n, float* y) {
+	avx2::fastTanh(x, n, y);
+}
+
+}
+
+#endif
+
+}
+
+}
+
+#endif
@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef SOFTMAX_FUNCTION_H_
+#define SOFTMAX_FUNCTION_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "ActivationId.h"
+
+namespace mlp {
+
+/// Template class representing a softmax activation function
+/**
+	Activation function @f$ f(x)_i = \frac{e^{x_i}}{\sum_j e^{x_j}} @f$ ,
+	which turns the sums of a whole layer into a probability distribution.
+	Unlike other activation functions, it is not applied to each value
+	separately, so `ActivationFunction` processes layers through `apply`
+	and `applyDerivative` of this class. The single-value functions `f`
+	and `df` describe the unnormalized exponential and are only meaningful
+	up to the normalization.
+
+	Softmax is intended for the output layer of a classifier trained with
+	`LossId::crossEntropy`, in which case the derivative is never evaluated.
+
+	@tparam T Must meet the requirements of `NumericType` and for a variable
+	          `x` of type `T`, the expression `std::exp(x)` must be well formed
+*/
+template<typename T>
+class SoftmaxFunction {
+public:
+	/// Identifier of the function
+	constexpr static ActivationId id = ActivationId::softmax;
+	/// Returns unnormalized softmax function value
+	constexpr static T f(T x);
+	/// Returns unnormalized softmax function derivative value
+	constexpr static T df(T x);
+	/// Computes the function for a layer
+	static void apply(const T* first, std::size_t count, T* out);
+	/// Multiplies factors of a layer by the Jacobian of the function
+	static void applyDerivative(const T* values, std::size_t count, T* factors);
+};
+
+/**
+	@param[in] x Function argument
+
+	@returns Unnormalized function value @f$ e^x @f$
+*/
+template<typename T>
+constexpr T SoftmaxFunction<T>::f(T x) {
+	return std::exp(x);
+}
+
+/**
+	@param[in] x Derivative argument
+
+	@returns Unnormalized derivative value @f$ e^x @f$
+*/
+template<typename T>
+constexpr T SoftmaxFunction<T>::df(T x) {
+	return std::exp(x);
+}
+
+/**
+	Stores the function of the arguments `[first, first + count)` in the
+	range beginning at `out`. The largest argument is subtracted from all
+	arguments before exponentiation, so large sums do not overflow. The
+	ranges may be equal but must not otherwise overlap.
+
+	@param[in]  first The beginning of the argument range
+	@param[in]  count Number of arguments
+	@param[out] out   The beginning of the destination range
+*/
+template<typename T>
+void SoftmaxFunction<T>::apply(const T* first, std::size_t count, T* out) {
+	if (count == 0)
+		return;
+	const T max = *std::max_element(first, first + count);
+	T sum = T();
+	for (std::size_t i = 0; i < count; ++i) {
+		out[i] = std::exp(first[i] - max);
+		sum += out[i];
+	}
+	const T scale = T(1) / sum;
+	for (std::size_t i = 0; i < count; ++i) {
+		out[i] *= scale;
+	}
+}
+
+/**
+	Replaces the factors @f$ \delta @f$ with the product of the transposed
+	Jacobian and the factors,
+	@f$ \delta_i \leftarrow y_i (\delta_i - \sum_j y_j \delta_j) @f$ , as
+	required by backpropagation.
+
+	@param[in]     values  The beginning of the range of function values
+	@param[in]     count   Number of values
+	@param[in,out] factors The beginning of the factor range
+*/
+template<typename T>
+void SoftmaxFunction<T>::applyDerivative(const T* values, std::size_t count, T* factors) {
+	T sum = T();
+	for (std::size_t i = 0; i < count; ++i) {
+		sum += values[i] * factors[i];
+	}
+	for (std::size_t i = 0; i < count; ++i) {
+		factors[i] = values[i] * (factors[i] - sum);
+	}
+}
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace mlp {
+
+/// Template class representing a bounded lock-free single-producer single-consumer queue
+/**
+	The queue is a ring buffer whose read and write positions are atomic
+	counters kept in separate cache lines. Exactly one thread may push and
+	exactly one thread may pop at a time; neither operation blocks or
+	allocates.
+
+	@tparam T Type of stored elements; must be default-constructible and
+	          copy-assignable
+*/
+template<typename T>
+class SpscQueue {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Constructs an empty queue
+	explicit SpscQueue(std::size_t capacity);
+	/// Copy constructor (deleted)
+	SpscQueue(const SpscQueue&) = delete;
+	/// Copy assignment operator (deleted)
+	SpscQueue& operator=(const SpscQueue&) = delete;
+	/// Appends an element if the queue is not full
+	bool tryPush(const T& value);
+	/// Removes the first element if the queue is not empty
+	bool tryPop(T& value);
+private:
+	std::vector<T> slots;
+	alignas(64) std::atomic<std::size_t> head{0};
+	alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+/**
+	@param[in] capacity Maximum number of stored elements
+*/
+template<typename T>
+SpscQueue<T>::SpscQueue(std::size_t capacity)
+	: slots(capacity + 1) {}
+
+/**
+	May only be called by the producer thread.
+
+	@param[in] value The element to append
+
+	@returns `true` if the element was appended, `false` if the queue was
+	         full
+*/
+template<typename T>
+bool SpscQueue<T>::tryPush(const T& value) {
+	const std::size_t position = tail.load(std::memory_order_relaxed);
+	const std::size_t next = position + 1 == slots.size() ? 0 : position + 1;
+	if (next == head.load(std::memory_order_acquire)) {
+		return false;
+	}
+	slots[position] = value;
+	tail.store(next, std::memory_order_release);
+	return true;
+}
+
+/**
+	May only be called by the consumer thread.
+
+	@param[out] value Destination of the removed element
+
+	@returns `true` if an element was removed, `false` if the queue was
+	         empty
+*/
+template<typename T>
+bool SpscQueue<T>::tryPop(T& value) {
+	const std::size_t position = head.load(std::memory_order_relaxed);
+	if (position == tail.load(std::memory_order_acquire)) {
+		return false;
+	}
+	value = slots[position];
+	head.store(position + 1 == slots.size() ? 0 : position + 1, std::memory_order_release);
+	return true;
+}
+
+}
+
+#endif
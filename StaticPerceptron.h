@@ -0,0 +1,316 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef STATIC_PERCEPTRON_H_
+#define STATIC_PERCEPTRON_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "ActivationFunction.h"
+#include "MultiLayerPerceptron.h"
+#include "SoftmaxFunction.h"
+
+namespace mlp {
+
+/// Template structure representing a layer of a `StaticPerceptron`
+/**
+	Weights are stored in column-major order, i.e. the weights of all
+	neurons for the first input come first, so that a layer is computed
+	as a sequence of scaled additions of whole columns, which vectorize
+	without reordering any sum.
+
+	@tparam T    Value type of weights and biases
+	@tparam Rows Number of neurons
+	@tparam Cols Number of inputs of every neuron
+*/
+template<typename T, std::size_t Rows, std::size_t Cols>
+struct StaticLayer {
+	/// Number of neurons
+	static constexpr std::size_t size = Rows;
+	/// Number of inputs of every neuron
+	static constexpr std::size_t inputSize = Cols;
+	/// Column-major weight matrix
+	std::array<T, Rows * Cols> weights;
+	/// Bias vector
+	std::array<T, Rows> biases;
+};
+
+/// Template class representing a multilayer perceptron of a fixed topology
+/**
+	Declared as `StaticPerceptron<T, std::tuple<Activations...>, Sizes...>`,
+	where `Sizes` are the size of the input followed by the sizes of all
+	layers, and `Activations` are the activation function classes of the
+	layers, such as `LogisticFunction<T>`. All weights and biases are
+	stored inline in `std::array` members and every loop has a trip count
+	known at compile time, so the compiler may unroll and vectorize the
+	whole network, and `test` uses neither the heap nor indirect calls.
+	The loop over the neurons of every layer is unrolled explicitly, so
+	layers should not be wider than a few dozen neurons. The fast logistic
+	function and hyperbolic tangent are computed by the vectorized kernels
+	on sums padded to a whole number of vectors.
+
+	A static perceptron is meant for inference with small networks of
+	a topology fixed at build time. It is usually imported from a trained
+	`MultiLayerPerceptron` of the same topology, whose outputs it matches
+	up to rounding, or initialized from constant layers, e.g. ones
+	generated into a header.
+
+	@tparam T           Must meet the requirements of `NumericType`
+	@tparam Activations A `std::tuple` of activation function classes with
+	                    a static member `f`, one for every layer
+	@tparam Sizes       Size of the input followed by sizes of all layers
+*/
+template<typename T, class Activations, std::size_t... Sizes>
+class StaticPerceptron;
+
+template<typename T, class... Activations, std::size_t... Sizes>
+class StaticPerceptron<T, std::tuple<Activations...>, Sizes...> {
+	static_assert(sizeof...(Activations) > 0, "a perceptron needs at least one layer");
+	static_assert(sizeof...(Activations) + 1 == sizeof...(Sizes), "every layer needs exactly one activation function");
+	static constexpr std::array<std::size_t, sizeof...(Sizes)> sizes = {Sizes...};
+	template<std::size_t... I>
+	static std::tuple<StaticLayer<T, sizes[I + 1], sizes[I]>...> makeLayers(std::index_sequence<I...>);
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Types of all layers
+	using Layers = decltype(makeLayers(std::index_sequence_for<Activations...>()));
+	/// Type of a layer
+	template<std::size_t I>
+	using Layer = std::tuple_element_t<I, Layers>;
+	/// Activation function class of a layer
+	template<std::size_t I>
+	using Activation = std::tuple_element_t<I, std::tuple<Activations...>>;
+	/// Constructs the perceptron with all weights and biases set to zero
+	constexpr StaticPerceptron() = default;
+	/// Constructs the perceptron from given layers
+	constexpr explicit StaticPerceptron(const Layers& layers);
+	/// Constructs the perceptron with weights and biases of a dynamic perceptron
+	template<typename U, typename A>
+	explicit StaticPerceptron(const MultiLayerPerceptron<U, A>& perceptron);
+	/// Obtains number of layers of the perceptron
+	static constexpr std::size_t size();
+	/// Obtains size of the widest layer, including the input
+	static constexpr std::size_t width();
+	/// Obtains size of perceptron input
+	static constexpr std::size_t inputSize();
+	/// Obtains size of perceptron output
+	static constexpr std::size_t outputSize();
+	/// Obtains a layer of the perceptron
+	template<std::size_t I>
+	Layer<I>& layer();
+	/// Obtains a layer of the perceptron
+	template<std::size_t I>
+	constexpr const Layer<I>& layer() const;
+	/// Produces neural network output based on provided input data
+	template<class InputIt, class OutputIt>
+	void test(InputIt first, OutputIt out) const;
+private:
+	static constexpr std::size_t padded(std::size_t count);
+	using Buffer = std::array<T, padded(std::max({Sizes...}))>;
+	template<typename U, typename A, std::size_t... I>
+	void import(const MultiLayerPerceptron<U, A>& perceptron, std::index_sequence<I...>);
+	template<std::size_t... I>
+	void run(Buffer* buffers, std::index_sequence<I...>) const;
+	template<std::size_t I>
+	void process(const T* input, T* output) const;
+	template<std::size_t... I, class Body>
+	static void unroll(std::index_sequence<I...>, Body body);
+	Layers layers{};
+};
+
+/**
+	@param[in] layers Weights and biases of all layers
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+constexpr StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::StaticPerceptron(const Layers& layers)
+	: layers(layers) {}
+
+/**
+	Copies weights and biases of `perceptron`, converting them to `T`.
+
+	@param[in] perceptron A perceptron with the same layer sizes and
+	                      activation functions
+
+	@throws std::invalid_argument If the topology or any activation
+	                              function of `perceptron` differs
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+template<typename U, typename A>
+StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::StaticPerceptron(const MultiLayerPerceptron<U, A>& perceptron) {
+	if (perceptron.inputSize() != inputSize() || perceptron.size() != size()) {
+		throw std::invalid_argument("perceptron topology does not match");
+	}
+	import(perceptron, std::index_sequence_for<Activations...>());
+}
+
+/**
+	@returns Number of layers
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+constexpr std::size_t StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::size() {
+	return sizeof...(Activations);
+}
+
+/**
+	@returns Size of the widest layer or of the input, if it is wider
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+constexpr std::size_t StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::width() {
+	return std::max({Sizes...});
+}
+
+/**
+	@returns Size of perceptron input
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+constexpr std::size_t StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::inputSize() {
+	return sizes.front();
+}
+
+/**
+	@returns Size of perceptron output
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+constexpr std::size_t StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::outputSize() {
+	return sizes.back();
+}
+
+/**
+	@tparam I Index of the layer
+
+	@returns Reference to the layer
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+template<std::size_t I>
+auto StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::layer() -> Layer<I>& {
+	return std::get<I>(layers);
+}
+
+/**
+	@tparam I Index of the layer
+
+	@returns Constant reference to the layer
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+template<std::size_t I>
+constexpr auto StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::layer() const -> const Layer<I>& {
+	return std::get<I>(layers);
+}
+
+/**
+	Interprets the range `[first, first + inputSize())` as perceptron input,
+	feeds it to the neural network and stores the result in the range
+	`[out, out + outputSize())`. Intermediate results are kept in two
+	buffers on the stack.
+
+	@tparam     InputIt  Must meet the requirements of `InputIterator`
+	@tparam     OutputIt Must meet the requirements of `OutputIterator`
+	@param[in]  first    The beginning of the input range
+	@param[out] out      The beginning of the output range
+*/
+template<typename T, class... Activations, std::size_t... Sizes>
+template<class InputIt, class OutputIt>
+void StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::test(InputIt first, OutputIt out) const {
+	Buffer buffers[2];
+	std::copy_n(first, inputSize(), buffers[0].begin());
+	run(buffers, std::index_sequence_for<Activations...>());
+	std::copy_n(buffers[size() % 2].begin(), outputSize(), out);
+}
+
+template<typename T, class... Activations, std::size_t... Sizes>
+template<typename U, typename A, std::size_t... I>
+void StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::import(const MultiLayerPerceptron<U, A>& perceptron, std::index_sequence<I...>) {
+	(... , [&] {
+		const auto& source = perceptron.layer(I);
+		auto& target = std::get<I>(layers);
+		if (source.group.size() != Layer<I>::size || source.group.inputSize() != Layer<I>::inputSize) {
+			throw std::invalid_argument("perceptron topology does not match");
+		}
+		if (source.activation.id() != ActivationFunction<T>(Activation<I>()).id()) {
+			throw std::invalid_argument("perceptron activation functions do not match");
+		}
+		const U* weights = source.group.weightData();
+		for (std::size_t r = 0; r < Layer<I>::size; ++r) {
+			for (std::size_t c = 0; c < Layer<I>::inputSize; ++c) {
+				target.weights[c * Layer<I>::size + r] = T(weights[r * Layer<I>::inputSize + c]);
+			}
+			target.biases[r] = T(source.group.biasData()[r]);
+		}
+	}());
+}
+
+template<typename T, class... Activations, std::size_t... Sizes>
+template<std::size_t... I>
+void StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::run(Buffer* buffers, std::index_sequence<I...>) const {
+	(process<I>(buffers[I % 2].data(), buffers[(I + 1) % 2].data()), ...);
+}
+
+template<typename T, class... Activations, std::size_t... Sizes>
+template<std::size_t I>
+void StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::process(const T* input, T* output) const {
+	constexpr std::size_t rows = Layer<I>::size, cols = Layer<I>::inputSize;
+	const auto& layer = std::get<I>(layers);
+	constexpr bool vectorized = std::is_same_v<Activation<I>, FastLogisticFunction<T>> || std::is_same_v<Activation<I>, FastHyperbolicTangent<T>>;
+	std::array<T, vectorized ? padded(rows) : rows> sums{};
+	std::copy(layer.biases.begin(), layer.biases.end(), sums.begin());
+	for (std::size_t c = 0; c < cols; ++c) {
+		const T x = input[c];
+		const T* column = layer.weights.data() + c * rows;
+		unroll(std::make_index_sequence<rows>(), [&](std::size_t r) {
+			sums[r] += column[r] * x;
+		});
+	}
+	if constexpr (std::is_same_v<Activation<I>, SoftmaxFunction<T>>) {
+		SoftmaxFunction<T>::apply(sums.data(), rows, output);
+	} else if constexpr (std::is_same_v<Activation<I>, FastLogisticFunction<T>>) {
+		kernels::fastLogistic(sums.data(), sums.size(), output);
+	} else if constexpr (std::is_same_v<Activation<I>, FastHyperbolicTangent<T>>) {
+		kernels::fastTanh(sums.data(), sums.size(), output);
+	} else {
+		unroll(std::make_index_sequence<rows>(), [&](std::size_t r) {
+			output[r] = Activation<I>::f(sums[r]);
+		});
+	}
+}
+
+template<typename T, class... Activations, std::size_t... Sizes>
+constexpr std::size_t StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::padded(std::size_t count) {
+	return (count + 7) / 8 * 8;
+}
+
+template<typename T, class... Activations, std::size_t... Sizes>
+template<std::size_t... I, class Body>
+void StaticPerceptron<T, std::tuple<Activations...>, Sizes...>::unroll(std::index_sequence<I...>, Body body) {
+	(body(I), ...);
+}
+
+}
+
+#endif
@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef TEXT_LOADER_H_
+#define TEXT_LOADER_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "DataSet.h"
+#include "MemoryMappedFile.h"
+#include "ThreadPool.h"
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define MLP_FLOATING_FROM_CHARS
+#endif
+
+namespace mlp {
+
+/// Loads a whitespace-separated text data set in parallel
+template<typename T>
+std::size_t loadTextDataSet(const std::string& path, DataSet<T>& dataSet, bool classLabels = false, std::size_t threadCount = 0);
+
+/// Helpers of the text loader
+namespace textLoader {
+
+/// Parses a number at the beginning of a range of characters
+template<typename V>
+std::from_chars_result parseNumber(const char* first, const char* last, V& value);
+
+/**
+	Calls `std::from_chars`, except for floating point values when the
+	standard library does not implement it for them, as libc++ before
+	version 17 and libstdc++ before GCC 11. These are then copied up to
+	the next space, tab or carriage return and parsed with `std::strtof`,
+	`std::strtod` or `std::strtold`, which depend on the `LC_NUMERIC`
+	category of the C locale and accept a leading `+` and hexadecimal
+	values as well.
+
+	@param[in]  first Beginning of the range
+	@param[in]  last  End of the range
+	@param[out] value The parsed value; unchanged on failure
+
+	@returns End of the parsed number and `std::errc()` on success, or an
+	         error code if the range does not begin with a number or it is
+	         out of the range of `V`
+*/
+template<typename V>
+std::from_chars_result parseNumber(const char* first, const char* last, V& value) {
+#ifdef MLP_FLOATING_FROM_CHARS
+	return std::from_chars(first, last, value);
+#else
+	if constexpr (std::is_floating_point<V>::value) {
+		const char* const token = std::find_if(first, last, [](char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		});
+		const std::string text(first, token);
+		char* stop = nullptr;
+		errno = 0;
+		V result;
+		if constexpr (std::is_same<V, float>::value) {
+			result = std::strtof(text.c_str(), &stop);
+		} else if constexpr (std::is_same<V, double>::value) {
+			result = std::strtod(text.c_str(), &stop);
+		} else {
+			result = std::strtold(text.c_str(), &stop);
+		}
+		if (stop == text.c_str()) {
+			return {first, std::errc::invalid_argument};
+		}
+		if (errno == ERANGE) {
+			return {first + (stop - text.c_str()), std::errc::result_out_of_range};
+		}
+		value = result;
+		return {first + (stop - text.c_str()), std::errc()};
+	} else {
+		return std::from_chars(first, last, value);
+	}
+#endif
+}
+
+}
+
+/**
+	Reads a text file holding one test per line: `dataSet.inputSize()` input
+	values followed by either `dataSet.outputSize()` expected output values
+	or, if `classLabels` is `true`, a single class label between 1 and
+	`dataSet.outputSize()`, which is converted to a one-hot expected output.
+	Values are separated by spaces or tabs; empty lines are skipped. This is
+	the format of the text files used by the example program.
+
+	The file is mapped into memory and split into one chunk per thread at
+	line boundaries. Chunks are parsed concurrently with `std::from_chars`,
+	which does not depend on the locale, or with the fallback described at
+	`textLoader::parseNumber`, and the parsed tests are appended to
+	`dataSet` in the order of the file.
+
+	@param[in]     path        Path to the text file
+	@param[in,out] dataSet     The data set to append the tests to
+	@param[in]     classLabels Whether outputs are given as class labels
+	@param[in]     threadCount Number of parsing threads; 0 means one per
+	                           hardware thread
+
+	@returns Number of loaded tests
+
+	@throws std::system_error  If the file cannot be mapped
+	@throws std::runtime_error If a line is malformed; `dataSet` is then left
+	                           unchanged
+*/
+template<typename T>
+std::size_t loadTextDataSet(const std::string& path, DataSet<T>& dataSet, bool classLabels, std::size_t threadCount) {
+	const MemoryMappedFile file(path);
+	const char* const text = reinterpret_cast<const char*>(file.data());
+	const std::size_t size = file.size();
+	const std::size_t inputSize = dataSet.inputSize();
+	const std::size_t outputSize = dataSet.outputSize();
+	ThreadPool pool(threadCount == 0 ? std::thread::hardware_concurrency() : threadCount);
+	const std::size_t chunkCount = std::max<std::size_t>(1, std::min(pool.size(), size / 65536));
+	std::vector<std::size_t> bounds(chunkCount + 1, size);
+	bounds.front() = 0;
+	for (std::size_t i = 1; i < chunkCount; ++i) {
+		const char* start = text + std::max(size * i / chunkCount, bounds[i - 1]);
+		const char* newline = std::find(start, text + size, '\n');
+		bounds[i] = newline == text + size ? size : newline - text + 1;
+	}
+	std::vector<DataSet<T>> chunks(chunkCount, DataSet<T>(inputSize, outputSize));
+	pool.run(chunkCount, [&](std::size_t chunk) {
+		const char* first = text + bounds[chunk];
+		const char* const last = text + bounds[chunk + 1];
+		std::vector<T> input(inputSize);
+		std::vector<T> output(outputSize);
+		chunks[chunk].reserve((last - first) / (8 * (inputSize + outputSize) + 1));
+		while (first != last) {
+			const char* const end = std::find(first, last, '\n');
+			auto next = [&]() {
+				while (first != end && (*first == ' ' || *first == '\t' || *first == '\r')) {
+					++first;
+				}
+				return first != end;
+			};
+			auto fail = [&]() {
+				throw std::runtime_error(path + ": malformed line at byte " + std::to_string(first - text));
+			};
+			auto parse = [&](auto& value) {
+				if (!next()) {
+					fail();
+				}
+				const auto result = textLoader::parseNumber(first, end, value);
+				if (result.ec != std::errc() || (result.ptr != end && *result.ptr != ' ' && *result.ptr != '\t' && *result.ptr != '\r')) {
+					fail();
+				}
+				first = result.ptr;
+			};
+			if (next()) {
+				for (T& value : input) {
+					parse(value);
+				}
+				if (classLabels) {
+					std::size_t label = 0;
+					parse(label);
+					if (label < 1 || label > outputSize) {
+						fail();
+					}
+					std::fill(output.begin(), output.end(), T());
+					output[label - 1] = T(1);
+				} else {
+					for (T& value : output) {
+						parse(value);
+					}
+				}
+				if (next()) {
+					fail();
+				}
+				chunks[chunk].addTest(input.begin(), output.begin());
+			}
+			first = end == last ? last : end + 1;
+		}
+	});
+	std::size_t count = 0;
+	for (const auto& chunk : chunks) {
+		count += chunk.size();
+	}
+	dataSet.reserve(dataSet.size() + count);
+	for (const auto& chunk : chunks) {
+		if (chunk.size() != 0) {
+			dataSet.addTests(chunk.input(0), chunk.output(0), chunk.size());
+		}
+	}
+	return count;
+}
+
+}
+
+#endif
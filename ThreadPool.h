@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mlp {
+
+/// Class representing a fixed set of worker threads
+/**
+	A thread pool runs batches of indexed tasks. The calling thread takes
+	part in executing the tasks, so a pool of size `n` starts `n - 1` worker
+	threads. Which thread runs which task is unspecified; callers wanting
+	reproducible results should make each task depend on its index only.
+*/
+class ThreadPool {
+public:
+	/// Constructs the pool
+	explicit ThreadPool(std::size_t size);
+	/// Copy constructor (deleted)
+	ThreadPool(const ThreadPool&) = delete;
+	/// Copy assignment operator (deleted)
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	/// Stops and joins the worker threads
+	~ThreadPool();
+	/// Obtains number of threads running tasks, including the calling thread
+	std::size_t size() const;
+	/// Runs tasks with indices `[0, count)` and waits for their completion
+	template<class Function>
+	void run(std::size_t count, Function function);
+private:
+	void work();
+	void execute(std::unique_lock<std::mutex>& lock);
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	std::function<void(std::size_t)> task;
+	std::exception_ptr exception;
+	std::size_t taskCount = 0;
+	std::size_t nextTask = 0;
+	std::size_t remaining = 0;
+	std::size_t generation = 0;
+	bool stopping = false;
+};
+
+/**
+	@param[in] size Number of threads running tasks, including the calling
+	                thread; 0 is treated as 1
+*/
+inline ThreadPool::ThreadPool(std::size_t size) {
+	for (std::size_t i = 1; i < size; ++i) {
+		workers.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+inline ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto&& worker : workers) {
+		worker.join();
+	}
+}
+
+/**
+	@returns Number of threads running tasks, including the calling thread
+*/
+inline std::size_t ThreadPool::size() const {
+	return workers.size() + 1;
+}
+
+/**
+	Calls `function(i)` once for every `i` in `[0, count)`, distributing the
+	calls among the threads of the pool, and returns once all of them have
+	completed. If any call throws, the first exception caught is rethrown
+	after all calls have completed.
+
+	@tparam    Function An invokable type with signature equivalent to
+	                    `void f(std::size_t)`
+	@param[in] count    Number of tasks
+	@param[in] function The task function
+*/
+template<class Function>
+void ThreadPool::run(std::size_t count, Function function) {
+	if (workers.empty() || count <= 1) {
+		for (std::size_t i = 0; i < count; ++i) {
+			function(i);
+		}
+		return;
+	}
+	std::unique_lock<std::mutex> lock(mutex);
+	task = std::ref(function);
+	taskCount = count;
+	nextTask = 0;
+	remaining = count;
+	++generation;
+	wake.notify_all();
+	execute(lock);
+	done.wait(lock, [&] {return remaining == 0;});
+	task = nullptr;
+	if (exception) {
+		std::rethrow_exception(std::exchange(exception, nullptr));
+	}
+}
+
+inline void ThreadPool::work() {
+	std::unique_lock<std::mutex> lock(mutex);
+	std::size_t seen = generation;
+	for (;;) {
+		wake.wait(lock, [&] {return stopping || generation != seen;});
+		if (stopping)
+			return;
+		seen = generation;
+		execute(lock);
+	}
+}
+
+inline void ThreadPool::execute(std::unique_lock<std::mutex>& lock) {
+	while (nextTask < taskCount) {
+		std::size_t index = nextTask++;
+		lock.unlock();
+		try {
+			task(index);
+		} catch (...) {
+			lock.lock();
+			if (!exception)
+				exception = std::current_exception();
+			lock.unlock();
+		}
+		lock.lock();
+		if (--remaining == 0)
+			done.notify_all();
+	}
+}
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef TRAINING_REPORT_H_
+#define TRAINING_REPORT_H_
+
+#include <cstddef>
+
+namespace mlp {
+
+/// Structure summarizing a training run
+/**
+	A training report is returned by `PerceptronTrainer::train`. It tells
+	a run that reached the error threshold from one that was stopped by the
+	limit of epochs, and records the error the run ended with.
+*/
+struct TrainingReport {
+	/// Number of epochs run
+	std::size_t epochs = 0;
+	/// Average error per test of the last epoch
+	double error = 0.0;
+	/// Whether the error fell below the threshold
+	bool converged = false;
+	/// Duration of the run in seconds
+	double seconds = 0.0;
+};
+
+}
+
+#endif
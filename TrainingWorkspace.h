@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2018 Jan Filipowicz, Filip Turobos
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////
+
+#ifndef TRAINING_WORKSPACE_H_
+#define TRAINING_WORKSPACE_H_
+
+#include <cstddef>
+#include <vector>
+#include "AlignedAllocator.h"
+
+namespace mlp {
+
+/// Template class holding scratch buffers for perceptron training
+/**
+	A training workspace stores every intermediate result of a single
+	training step: the input and output activations of each layer, the
+	weighted sums computed by each layer and the error terms propagated
+	back through the network. It is sized once from the shape of
+	a perceptron, so that training steps reusing it perform no allocations.
+	A workspace may only be used by one training step at a time.
+
+	@tparam T Data type of stored values
+*/
+template<typename T>
+class TrainingWorkspace {
+public:
+	/// Data type the class operates on
+	using ValueType = T;
+	/// Constructs an empty workspace
+	TrainingWorkspace() = default;
+	/// Constructs a workspace matching the shape of a perceptron
+	template<class Perceptron>
+	explicit TrainingWorkspace(const Perceptron& perceptron);
+	/// Obtains number of layers
+	std::size_t size() const;
+	/// Obtains input of a layer, or the network output for index `size()`
+	T* activations(std::size_t layer);
+	/// Obtains weighted sums computed by a layer
+	T* sums(std::size_t layer);
+	/// Obtains error terms of a layer input, or the network output for index `size()`
+	T* errors(std::size_t layer);
+private:
+	AlignedVector<T> values;
+	std::vector<std::size_t> activationOffsets;
+	std::vector<std::size_t> sumOffsets;
+	std::size_t errorOffset = 0;
+};
+
+/**
+	@tparam    Perceptron A perceptron type providing `size()`, `layer(i)`
+	                      and `layer(i).group.inputSize()`, such as
+	                      `MultiLayerPerceptron`
+	@param[in] perceptron The perceptron whose shape to match
+*/
+template<typename T>
+template<class Perceptron>
+TrainingWorkspace<T>::TrainingWorkspace(const Perceptron& perceptron) {
+	const std::size_t layers = perceptron.size();
+	std::size_t offset = 0;
+	activationOffsets.reserve(layers + 1);
+	sumOffsets.reserve(layers);
+	for (std::size_t i = 0; i < layers; ++i) {
+		activationOffsets.push_back(offset);
+		offset += perceptron.layer(i).group.inputSize();
+	}
+	activationOffsets.push_back(offset);
+	offset += layers == 0 ? perceptron.width() : perceptron.layer(layers - 1).group.size();
+	errorOffset = offset;
+	offset *= 2;
+	for (std::size_t i = 0; i < layers; ++i) {
+		sumOffsets.push_back(offset);
+		offset += perceptron.layer(i).group.size();
+	}
+	values.resize(offset);
+}
+
+/**
+	@returns Number of layers of the matched perceptron
+*/
+template<typename T>
+std::size_t TrainingWorkspace<T>::size() const {
+	return sumOffsets.size();
+}
+
+/**
+	@param[in] layer Index of the layer, at most `size()`
+
+	@returns Pointer to the beginning of the activation buffer
+*/
+template<typename T>
+T* TrainingWorkspace<T>::activations(std::size_t layer) {
+	return values.data() + activationOffsets[layer];
+}
+
+/**
+	@param[in] layer Index of the layer, less than `size()`
+
+	@returns Pointer to the beginning of the weighted sum buffer
+*/
+template<typename T>
+T* TrainingWorkspace<T>::sums(std::size_t layer) {
+	return values.data() + sumOffsets[layer];
+}
+
+/**
+	Error terms share the layout of activations, i.e. `errors(i)` has as
+	many elements as `activations(i)`.
+
+	@param[in] layer Index of the layer, at most `size()`
+
+	@returns Pointer to the beginning of the error term buffer
+*/
+template<typename T>
+T* TrainingWorkspace<T>::errors(std::size_t layer) {
+	return values.data() + errorOffset + activationOffsets[layer];
+}
+
+}
+
+#endif
@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "ActivationFunction.h"
+#include "ActivationId.h"
+#include "DataSet.h"
+#include "InferenceContext.h"
+#include "Kernels.h"
+#include "MultiLayerPerceptron.h"
+#include "NeuronLayerSpecification.h"
+#include "PerceptronTrainer.h"
+#include "StaticPerceptron.h"
+
+// Usage: benchmark [--quick] [--threads=1,2,...] [--filter=text] [--output=file]
+//
+// Measures single-input inference latency, batched inference throughput and
+// training throughput for every combination of topology, activation
+// function, value type and thread count, and prints the results as JSON.
+// The latency of a StaticPerceptron is measured for the smallest topology.
+// Training throughput counts only the durations of epochs reported to the
+// epoch callback, excluding the first epoch of every call, so that setting
+// up a training run is not measured. Gradient norms are not tracked, so the
+// epochs run the same code path as training without a callback.
+// With --filter, only benchmarks whose name contains the text are run.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+	double minSeconds = 0.25;
+	std::vector<std::size_t> threadCounts;
+	std::string filter;
+	std::string output;
+};
+
+struct Topology {
+	const char* name;
+	std::vector<std::size_t> sizes;
+	std::size_t trainingTests;
+};
+
+struct Result {
+	std::string name;
+	std::string type;
+	std::string topology;
+	std::string activation;
+	std::string benchmark;
+	std::size_t threads;
+	std::size_t batchSize;
+	std::size_t iterations;
+	double seconds;
+	double samplesPerSecond;
+	double nanosecondsPerSample;
+};
+
+const Topology topologies[] = {
+	{"4-17-3", {4, 17, 3}, 4096},
+	{"64-64-10", {64, 64, 10}, 2048},
+	{"256-256-256-10", {256, 256, 256, 10}, 512},
+	{"1024-1024-1024-1024-10", {1024, 1024, 1024, 1024, 10}, 64},
+};
+
+const mlp::ActivationId activations[] = {
+	mlp::ActivationId::identity,
+	mlp::ActivationId::logistic,
+	mlp::ActivationId::hyperbolicTangent,
+	mlp::ActivationId::rectifier,
+	mlp::ActivationId::fastLogistic,
+	mlp::ActivationId::fastHyperbolicTangent,
+};
+
+const std::size_t inferenceBatchSize = 64;
+const std::size_t trainingBatchSize = 32;
+
+const char* activationName(mlp::ActivationId id) {
+	switch (id) {
+	case mlp::ActivationId::identity:
+		return "identity";
+	case mlp::ActivationId::logistic:
+		return "logistic";
+	case mlp::ActivationId::hyperbolicTangent:
+		return "tanh";
+	case mlp::ActivationId::rectifier:
+		return "rectifier";
+	case mlp::ActivationId::fastLogistic:
+		return "fastLogistic";
+	case mlp::ActivationId::fastHyperbolicTangent:
+		return "fastTanh";
+	default:
+		return "custom";
+	}
+}
+
+const char* simdName(mlp::kernels::SimdLevel level) {
+	switch (level) {
+	case mlp::kernels::SimdLevel::avx512:
+		return "avx512";
+	case mlp::kernels::SimdLevel::avx2:
+		return "avx2";
+	case mlp::kernels::SimdLevel::sse2:
+		return "sse2";
+	default:
+		return "none";
+	}
+}
+
+template<typename T>
+const char* typeName();
+
+template<>
+const char* typeName<float>() {
+	return "float";
+}
+
+template<>
+const char* typeName<double>() {
+	return "double";
+}
+
+// Runs step once to warm up, then repeatedly until minSeconds have passed
+template<class Step>
+std::pair<std::size_t, double> measure(Step step, double minSeconds) {
+	step();
+	std::size_t iterations = 0;
+	const auto start = Clock::now();
+	double elapsed;
+	do {
+		step();
+		++iterations;
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	} while (elapsed < minSeconds);
+	return {iterations, elapsed};
+}
+
+// Trains for whole epochs until minSeconds of them have passed, not counting
+// the first epoch of every call, which also allocates the optimizer state
+template<class Trainer, class Perceptron, class Source>
+std::pair<std::size_t, double> measureEpochs(Trainer& trainer, Perceptron& perceptron, const Source& data, double minSeconds) {
+	std::size_t epochs = 0;
+	double elapsed = 0.0;
+	trainer.setGradientNormTracking(false);
+	trainer.setEpochCallback([&](const mlp::EpochStatistics& statistics) {
+		if (statistics.epoch > 1) {
+			++epochs;
+			elapsed += statistics.seconds;
+		}
+	});
+	std::size_t count = 1;
+	while (elapsed < minSeconds) {
+		trainer.setMaxEpochs(count + 1);
+		trainer.train(perceptron, data);
+		count = elapsed > 0.0 ? std::size_t(std::ceil((minSeconds - elapsed) * epochs / elapsed)) : count * 2;
+	}
+	return {epochs, elapsed};
+}
+
+template<typename T>
+mlp::MultiLayerPerceptron<T> makePerceptron(const Topology& topology, mlp::ActivationId id, std::mt19937_64& engine) {
+	std::vector<mlp::NeuronLayerSpecification<T>> layers;
+	for (std::size_t i = 1; i < topology.sizes.size(); ++i) {
+		layers.push_back({topology.sizes[i], mlp::ActivationFunction<T>(id)});
+	}
+	mlp::MultiLayerPerceptron<T> perceptron(topology.sizes.front(), layers.begin(), layers.end());
+	std::uniform_real_distribution<T> distribution(T(-0.1), T(0.1));
+	perceptron.generateWeights([&] { return distribution(engine); });
+	perceptron.generateBiases([&] { return distribution(engine); });
+	return perceptron;
+}
+
+template<typename T>
+mlp::DataSet<T> makeDataSet(const Topology& topology, std::size_t count, std::mt19937_64& engine) {
+	const std::size_t inputSize = topology.sizes.front(), outputSize = topology.sizes.back();
+	mlp::DataSet<T> data(inputSize, outputSize);
+	data.reserve(count);
+	std::uniform_real_distribution<T> distribution(T(-1), T(1));
+	std::vector<T> input(inputSize), output(outputSize);
+	for (std::size_t i = 0; i < count; ++i) {
+		for (auto& value : input) {
+			value = distribution(engine);
+		}
+		for (auto& value : output) {
+			value = (distribution(engine) + T(1)) / 2;
+		}
+		data.addTest(input.begin(), output.begin());
+	}
+	return data;
+}
+
+Result makeResult(std::string name, const char* type, const Topology& topology, mlp::ActivationId id, const char* benchmark, std::size_t threads, std::size_t batchSize, std::pair<std::size_t, double> timing, std::size_t samplesPerIteration) {
+	const double samples = double(timing.first) * samplesPerIteration;
+	return {std::move(name), type, topology.name, activationName(id), benchmark, threads, batchSize, timing.first, timing.second, samples / timing.second, timing.second * 1e9 / samples};
+}
+
+template<typename T>
+void run(const Options& options, std::vector<Result>& results) {
+	std::mt19937_64 engine(42);
+	for (const auto& topology : topologies) {
+		for (mlp::ActivationId id : activations) {
+			const std::string prefix = std::string(typeName<T>()) + "/" + topology.name + "/" + activationName(id) + "/";
+			auto perceptron = makePerceptron<T>(topology, id, engine);
+			const auto data = makeDataSet<T>(topology, std::max(topology.trainingTests, inferenceBatchSize), engine);
+			std::vector<T> output(inferenceBatchSize * perceptron.outputSize());
+			mlp::InferenceContext<T> context(perceptron.width(), inferenceBatchSize);
+			std::string name = prefix + "test";
+			if (name.find(options.filter) != std::string::npos) {
+				std::size_t next = 0;
+				const auto timing = measure([&] {
+					perceptron.test(data.input(next), output.begin(), context);
+					next = (next + 1) % data.size();
+				}, options.minSeconds);
+				results.push_back(makeResult(name, typeName<T>(), topology, id, "test", 1, 1, timing, 1));
+				std::cerr << name << std::endl;
+			}
+			name = prefix + "testBatch";
+			if (name.find(options.filter) != std::string::npos) {
+				const auto timing = measure([&] {
+					perceptron.testBatch(data.input(0), inferenceBatchSize, output.begin(), context);
+				}, options.minSeconds);
+				results.push_back(makeResult(name, typeName<T>(), topology, id, "testBatch", 1, inferenceBatchSize, timing, inferenceBatchSize));
+				std::cerr << name << std::endl;
+			}
+			for (std::size_t threads : options.threadCounts) {
+				name = prefix + "train/" + std::to_string(threads);
+				if (name.find(options.filter) == std::string::npos) {
+					continue;
+				}
+				mlp::PerceptronTrainer<T> trainer(topology.sizes.front(), topology.sizes.back());
+				trainer.setInitialWeightRange(T(0.1));
+				trainer.setLearningRate(T(1e-3));
+				trainer.setMomentum(T(0.9));
+				trainer.setBatchSize(trainingBatchSize);
+				trainer.setThreadCount(threads);
+				const auto timing = measureEpochs(trainer, perceptron, data, options.minSeconds);
+				results.push_back(makeResult(name, typeName<T>(), topology, id, "train", threads, trainingBatchSize, timing, data.size()));
+				std::cerr << name << std::endl;
+			}
+		}
+	}
+}
+
+template<typename T, template<typename> class Function>
+void runStatic(mlp::ActivationId id, const Options& options, std::vector<Result>& results) {
+	using Perceptron = mlp::StaticPerceptron<T, std::tuple<Function<T>, Function<T>>, 4, 17, 3>;
+	const Topology& topology = topologies[0];
+	const std::string name = std::string(typeName<T>()) + "/" + topology.name + "/" + activationName(id) + "/staticTest";
+	if (name.find(options.filter) == std::string::npos) {
+		return;
+	}
+	std::mt19937_64 engine(42);
+	const Perceptron perceptron(makePerceptron<T>(topology, id, engine));
+	const auto data = makeDataSet<T>(topology, inferenceBatchSize, engine);
+	std::vector<T> output(perceptron.outputSize());
+	std::size_t next = 0;
+	const auto timing = measure([&] {
+		perceptron.test(data.input(next), output.begin());
+		next = (next + 1) % data.size();
+	}, options.minSeconds);
+	results.push_back(makeResult(name, typeName<T>(), topology, id, "staticTest", 1, 1, timing, 1));
+	std::cerr << name << std::endl;
+}
+
+template<typename T>
+void runStatic(const Options& options, std::vector<Result>& results) {
+	runStatic<T, mlp::IdentityFunction>(mlp::ActivationId::identity, options, results);
+	runStatic<T, mlp::LogisticFunction>(mlp::ActivationId::logistic, options, results);
+	runStatic<T, mlp::HyperbolicTangent>(mlp::ActivationId::hyperbolicTangent, options, results);
+	runStatic<T, mlp::Rectifier>(mlp::ActivationId::rectifier, options, results);
+	runStatic<T, mlp::FastLogisticFunction>(mlp::ActivationId::fastLogistic, options, results);
+	runStatic<T, mlp::FastHyperbolicTangent>(mlp::ActivationId::fastHyperbolicTangent, options, results);
+}
+
+std::vector<std::size_t> parseList(const std::string& text) {
+	std::vector<std::size_t> values;
+	std::size_t position = 0;
+	while (position < text.size()) {
+		std::size_t end = text.find(',', position);
+		if (end == std::string::npos) {
+			end = text.size();
+		}
+		values.push_back(std::stoul(text.substr(position, end - position)));
+		position = end + 1;
+	}
+	return values;
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results) {
+	out << "{\n";
+	out << "\t\"simdLevel\": \"" << simdName(mlp::kernels::simdLevel()) << "\",\n";
+	out << "\t\"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n";
+	out << "\t\"results\": [";
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const Result& result = results[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "\t\t{\"name\": \"" << result.name << "\", \"type\": \"" << result.type
+			<< "\", \"topology\": \"" << result.topology << "\", \"activation\": \"" << result.activation
+			<< "\", \"benchmark\": \"" << result.benchmark << "\", \"threads\": " << result.threads
+			<< ", \"batchSize\": " << result.batchSize << ", \"iterations\": " << result.iterations
+			<< ", \"seconds\": " << result.seconds << ", \"samplesPerSecond\": " << result.samplesPerSecond
+			<< ", \"nanosecondsPerSample\": " << result.nanosecondsPerSample << "}";
+	}
+	out << "\n\t]\n}\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument == "--quick") {
+			options.minSeconds = 0.02;
+		} else if (argument.compare(0, 10, "--threads=") == 0) {
+			options.threadCounts = parseList(argument.substr(10));
+		} else if (argument.compare(0, 9, "--filter=") == 0) {
+			options.filter = argument.substr(9);
+		} else if (argument.compare(0, 9, "--output=") == 0) {
+			options.output = argument.substr(9);
+		} else {
+			std::cerr << "usage: " << argv[0] << " [--quick] [--threads=1,2,...] [--filter=text] [--output=file]" << std::endl;
+			return 1;
+		}
+	}
+	if (options.threadCounts.empty()) {
+		options.threadCounts.push_back(1);
+		if (std::thread::hardware_concurrency() > 1) {
+			options.threadCounts.push_back(std::thread::hardware_concurrency());
+		}
+	}
+	std::vector<Result> results;
+	run<float>(options, results);
+	run<double>(options, results);
+	runStatic<float>(options, results);
+	runStatic<double>(options, results);
+	if (options.output.empty()) {
+		writeJson(std::cout, results);
+	} else {
+		std::ofstream out(options.output);
+		writeJson(out, results);
+	}
+	return 0;
+}
@@ -0,0 +1,214 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "DataSet.h"
+#include "HyperbolicTangent.h"
+#include "IdentityFunction.h"
+#include "Lbfgs.h"
+#include "Loss.h"
+#include "LogisticFunction.h"
+#include "MultiLayerPerceptron.h"
+#include "NeuronLayerSpecification.h"
+#include "Optimizer.h"
+#include "PerceptronTrainer.h"
+#include "SoftmaxFunction.h"
+
+// Usage: convergence [--seeds=n] [--filter=text] [--output=file]
+//
+// Trains perceptrons on fixed synthetic problems with every trainer
+// configuration and reports, for each of several error levels, the epochs
+// and wall-clock time needed to reach the level, averaged over seeds, as
+// JSON. Training is deterministic for a given seed, so the run stopping at
+// a level follows the same trajectory as runs aiming at lower levels.
+// With --filter, only cases whose name contains the text are run.
+
+namespace {
+
+struct Options {
+	std::size_t seeds = 5;
+	std::string filter;
+	std::string output;
+};
+
+struct Problem {
+	const char* name;
+	std::vector<mlp::NeuronLayerSpecification<double>> layers;
+	mlp::DataSet<double> data;
+	std::vector<double> levels;
+	std::size_t maxEpochs;
+	mlp::LossId loss;
+};
+
+struct Configuration {
+	const char* name;
+	mlp::TrainingMethod method;
+	mlp::OptimizerId optimizer;
+	std::size_t batchSize;
+	double learningRate;
+	double momentum;
+};
+
+struct Summary {
+	std::string name;
+	double level;
+	std::size_t runs;
+	std::size_t reached;
+	double epochsMean;
+	double epochsStdDev;
+	double secondsMean;
+	double secondsStdDev;
+};
+
+const Configuration configurations[] = {
+	{"full-batch", mlp::TrainingMethod::gradientDescent, mlp::OptimizerId::momentum, 0, 1e-4, 0.9},
+	{"batch-32", mlp::TrainingMethod::gradientDescent, mlp::OptimizerId::momentum, 32, 1e-3, 0.8},
+	{"stochastic", mlp::TrainingMethod::gradientDescent, mlp::OptimizerId::momentum, 1, 1e-2, 0.5},
+	{"nesterov-batch-32", mlp::TrainingMethod::gradientDescent, mlp::OptimizerId::nesterov, 32, 1e-3, 0.8},
+	{"rmsprop-batch-32", mlp::TrainingMethod::gradientDescent, mlp::OptimizerId::rmsProp, 32, 1e-2, 0.0},
+	{"adam-batch-32", mlp::TrainingMethod::gradientDescent, mlp::OptimizerId::adam, 32, 1e-2, 0.9},
+	{"lbfgs", mlp::TrainingMethod::lbfgs, mlp::OptimizerId::momentum, 0, 0.0, 0.0},
+};
+
+// Approximation of a smooth function of one variable, as in main.cpp
+Problem makeRegression() {
+	Problem problem{"regression", {{17, mlp::HyperbolicTangent<double>()}, {1, mlp::IdentityFunction<double>()}}, mlp::DataSet<double>(1, 1), {0.05, 0.02, 0.01}, 5000, mlp::LossId::squaredError};
+	std::mt19937_64 engine(1);
+	std::uniform_real_distribution<double> argument(-4, 4);
+	std::normal_distribution<double> noise(0, 0.05);
+	for (int i = 0; i < 200; ++i) {
+		const double x = argument(engine);
+		const double y = std::sin(x) + 0.3 * std::cos(3 * x) + noise(engine);
+		problem.data.addTest(&x, &y);
+	}
+	return problem;
+}
+
+// Three overlapping Gaussian classes in four dimensions, as in main.cpp
+Problem makeClassification() {
+	Problem problem{"classification", {{17, mlp::LogisticFunction<double>()}, {3, mlp::LogisticFunction<double>()}}, mlp::DataSet<double>(4, 3), {0.2, 0.16, 0.14}, 2000, mlp::LossId::squaredError};
+	std::mt19937_64 engine(2);
+	std::normal_distribution<double> noise(0, 1);
+	const double centers[3][4] = {{-1.5, 0.5, -0.5, 1}, {-2, 2, -0.5, 2.5}, {1, -1, 1, -1}};
+	for (int i = 0; i < 600; ++i) {
+		const int label = i % 3;
+		double input[4], output[3] = {0, 0, 0};
+		for (int j = 0; j < 4; ++j) {
+			input[j] = centers[label][j] + noise(engine);
+		}
+		output[label] = 1;
+		problem.data.addTest(input, output);
+	}
+	return problem;
+}
+
+// The same classes with a softmax output trained on cross-entropy
+Problem makeSoftmaxClassification() {
+	Problem problem = makeClassification();
+	problem.name = "classification-softmax";
+	problem.layers.back().activation = mlp::SoftmaxFunction<double>();
+	problem.levels = {0.4, 0.3, 0.27};
+	problem.loss = mlp::LossId::crossEntropy;
+	return problem;
+}
+
+// Computes the mean and the sample standard deviation
+std::pair<double, double> statistics(const std::vector<double>& values) {
+	double mean = 0, variance = 0;
+	for (double value : values) {
+		mean += value;
+	}
+	mean /= values.size();
+	for (double value : values) {
+		variance += (value - mean) * (value - mean);
+	}
+	return {mean, values.size() > 1 ? std::sqrt(variance / (values.size() - 1)) : 0.0};
+}
+
+void run(const Problem& problem, const Configuration& configuration, const Options& options, std::vector<Summary>& summaries) {
+	const std::string name = std::string(problem.name) + "/" + configuration.name;
+	if (name.find(options.filter) == std::string::npos) {
+		return;
+	}
+	for (double level : problem.levels) {
+		std::vector<double> epochs, seconds;
+		for (std::size_t seed = 1; seed <= options.seeds; ++seed) {
+			mlp::MultiLayerPerceptron<double> perceptron(problem.data.inputSize(), problem.layers.begin(), problem.layers.end());
+			perceptron.setLoss(problem.loss);
+			mlp::PerceptronTrainer<double> trainer(problem.data.inputSize(), problem.data.outputSize());
+			trainer.setMaxEpochs(problem.maxEpochs);
+			trainer.setErrorThreshold(level);
+			trainer.setInitialWeightRange(0.25);
+			trainer.setLearningRate(configuration.learningRate);
+			trainer.setMomentum(configuration.momentum);
+			trainer.setOptimizer(configuration.optimizer);
+			trainer.setMethod(configuration.method);
+			trainer.setBatchSize(configuration.batchSize);
+			trainer.setSeed(seed);
+			const auto report = trainer.train(perceptron, problem.data);
+			if (report.converged) {
+				epochs.push_back(double(report.epochs));
+				seconds.push_back(report.seconds);
+			}
+		}
+		Summary summary{name, level, options.seeds, epochs.size(), 0, 0, 0, 0};
+		if (!epochs.empty()) {
+			std::tie(summary.epochsMean, summary.epochsStdDev) = statistics(epochs);
+			std::tie(summary.secondsMean, summary.secondsStdDev) = statistics(seconds);
+		}
+		summaries.push_back(summary);
+		std::cerr << name << " " << level << ": " << summary.reached << "/" << summary.runs << std::endl;
+	}
+}
+
+void writeJson(std::ostream& out, const std::vector<Summary>& summaries) {
+	out << "{\n\t\"results\": [";
+	for (std::size_t i = 0; i < summaries.size(); ++i) {
+		const Summary& summary = summaries[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "\t\t{\"name\": \"" << summary.name << "\", \"level\": " << summary.level
+			<< ", \"runs\": " << summary.runs << ", \"reached\": " << summary.reached
+			<< ", \"epochsMean\": " << summary.epochsMean << ", \"epochsStdDev\": " << summary.epochsStdDev
+			<< ", \"secondsMean\": " << summary.secondsMean << ", \"secondsStdDev\": " << summary.secondsStdDev << "}";
+	}
+	out << "\n\t]\n}\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument.compare(0, 8, "--seeds=") == 0) {
+			options.seeds = std::stoul(argument.substr(8));
+		} else if (argument.compare(0, 9, "--filter=") == 0) {
+			options.filter = argument.substr(9);
+		} else if (argument.compare(0, 9, "--output=") == 0) {
+			options.output = argument.substr(9);
+		} else {
+			std::cerr << "usage: " << argv[0] << " [--seeds=n] [--filter=text] [--output=file]" << std::endl;
+			return 1;
+		}
+	}
+	const Problem problems[] = {makeRegression(), makeClassification(), makeSoftmaxClassification()};
+	std::vector<Summary> summaries;
+	for (const auto& problem : problems) {
+		for (const auto& configuration : configurations) {
+			run(problem, configuration, options, summaries);
+		}
+	}
+	if (options.output.empty()) {
+		writeJson(std::cout, summaries);
+	} else {
+		std::ofstream out(options.output);
+		writeJson(out, summaries);
+	}
+	return 0;
+}
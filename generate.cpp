@@ -0,0 +1,67 @@
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "HeaderGenerator.h"
+#include "ModelFile.h"
+
+// Usage: generate [--double] [--output=file] model name
+//
+// Reads a model file written by saveModel and writes a standalone C++ header
+// computing its output in namespace name. The model is read as float unless
+// --double is given. Without --output, the header is written to standard
+// output.
+
+namespace {
+
+struct Options {
+	bool useDouble = false;
+	std::string output;
+	std::string model;
+	std::string name;
+};
+
+template<typename T>
+void generate(const Options& options) {
+	const auto perceptron = mlp::loadModel<T>(options.model);
+	if (options.output.empty()) {
+		mlp::generateHeader(perceptron, options.name, std::cout);
+	} else {
+		mlp::generateHeader(perceptron, options.name, options.output);
+	}
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	std::size_t positional = 0;
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument == "--double") {
+			options.useDouble = true;
+		} else if (argument.compare(0, 9, "--output=") == 0) {
+			options.output = argument.substr(9);
+		} else if (argument.compare(0, 2, "--") != 0 && positional < 2) {
+			(positional++ == 0 ? options.model : options.name) = argument;
+		} else {
+			positional = 3;
+			break;
+		}
+	}
+	if (positional != 2) {
+		std::cerr << "usage: " << argv[0] << " [--double] [--output=file] model name" << std::endl;
+		return 1;
+	}
+	try {
+		if (options.useDouble) {
+			generate<double>(options);
+		} else {
+			generate<float>(options);
+		}
+	} catch (const std::exception& e) {
+		std::cerr << argv[0] << ": " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -38,16 +38,16 @@ int main() {
 }*/
 
 #include <algorithm>
-#include <array>
+#include <exception>
 #include <fstream>
 #include <iostream>
-#include <random>
-#include <utility>
+#include <iterator>
+#include "DataSet.h"
 #include "IdentityFunction.h"
 #include "LogisticFunction.h"
 #include "MultiLayerPerceptron.h"
-#include "RandomNumberGenerator.h"
 #include "PerceptronTrainer.h"
+#include "TextLoader.h"
 
 int main() {
 	mlp::MultiLayerPerceptron<double> network(4, {
@@ -60,31 +60,26 @@ int main() {
 	trainer.setInitialWeightRange(0.25);
 	trainer.setLearningRate(1e-3);
 	trainer.setMomentum(0.8);
-	std::ifstream trainingData("classification_train.txt");
-	for (double input[4]; trainingData >> input[0] >> input[1] >> input[2] >> input[3];) {
-		double output[3] {};
-		int outcome;
-		trainingData >> outcome;
-		output[outcome - 1] = 1.0;
-		trainer.addTest(input, output);
-	}
-	trainer.train(network);
-	std::vector<std::pair<std::array<double, 4>, int>> data;
-	std::ifstream testData("classification_test.txt");
-	for (std::array<double, 4> input; testData >> input[0] >> input[1] >> input[2] >> input[3];) {
-		int outcome;
-		testData >> outcome;
-		data.emplace_back(input, outcome);
+	mlp::DataSet<double> data(4, 3);
+	try {
+		mlp::loadTextDataSet("classification_train.txt", trainer.data(), true);
+		trainer.train(network);
+		mlp::loadTextDataSet("classification_test.txt", data, true);
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
 	}
 	std::ofstream out("classification_results_1.txt");
 	out << "Expected\tObtained\n";
 	int correct = 0;
-	for (const auto& inout : data) {
+	mlp::InferenceContext<double> context;
+	for (std::size_t i = 0; i < data.size(); ++i) {
 		double output[3];
-		network.test(inout.first.begin(), output);
+		network.test(data.input(i), output, context);
+		int expected = std::max_element(data.output(i), data.output(i) + 3) - data.output(i) + 1;
 		int result = std::max_element(std::begin(output), std::end(output)) - output + 1;
-		out << inout.second << '\t' << result << '\n';
-		correct += result == inout.second;
+		out << expected << '\t' << result << '\n';
+		correct += result == expected;
 	}
 	std::cout << correct << " out of " << data.size() << " guessed" << std::endl;
 	return 0;
@@ -0,0 +1,572 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "DataSet.h"
+#include "DataSetFile.h"
+#include "FastHyperbolicTangent.h"
+#include "FastLogisticFunction.h"
+#include "HeaderGenerator.h"
+#include "HyperbolicTangent.h"
+#include "IdentityFunction.h"
+#include "Kernels.h"
+#include "LogisticFunction.h"
+#include "MappedDataSet.h"
+#include "MappedPerceptron.h"
+#include "ModelFile.h"
+#include "MultiLayerPerceptron.h"
+#include "QuantizedPerceptron.h"
+#include "PerceptronTrainer.h"
+#include "Rectifier.h"
+#include "StaticPerceptron.h"
+
+// Usage: selfcheck [--compiler=command]
+//
+// Runs every kernel and a perceptron at every SIMD level supported by the
+// processor and compares the results with those of the scalar code, exactly
+// for integers and within a tolerance for floating point values. Then writes
+// a model and a data set to temporary files and reads them back, checks
+// that prefetching batches leaves training results unchanged and that both
+// training methods stop before the first epoch on an empty data set, and
+// compares a StaticPerceptron with the perceptron it was built from.
+// Checks that header generation rejects keywords and reserved names, then
+// generates a header from a perceptron, compiles a program using it
+// with the given compiler, c++ by default, and compares the output of the
+// program with that of the perceptron; an empty command skips this check.
+// Prints every failed check and returns 1 if any check failed.
+
+namespace {
+
+using mlp::kernels::SimdLevel;
+
+// Results of one run of the checked code, with the tolerance relative to
+// the magnitude of the reference values
+struct Output {
+	std::string name;
+	std::vector<double> values;
+	double tolerance;
+};
+
+class Checker {
+public:
+	void check(bool condition, const std::string& name) {
+		++checks;
+		if (!condition) {
+			++failures;
+			std::cout << "FAILED " << name << std::endl;
+		}
+	}
+	template<class Container>
+	void compare(const Container& reference, const Container& candidate, double tolerance, const std::string& name) {
+		bool equal = reference.size() == candidate.size();
+		for (std::size_t i = 0; equal && i < reference.size(); ++i) {
+			const double difference = std::abs(double(reference[i]) - double(candidate[i]));
+			equal = difference <= tolerance * std::max(1.0, std::abs(double(reference[i])));
+		}
+		check(equal, name);
+	}
+	int summarize() const {
+		std::cout << checks - failures << " of " << checks << " checks passed" << std::endl;
+		return failures == 0 ? 0 : 1;
+	}
+private:
+	std::size_t checks = 0;
+	std::size_t failures = 0;
+};
+
+const SimdLevel levels[] = {
+	SimdLevel::none,
+	SimdLevel::sse2,
+	SimdLevel::avx2,
+	SimdLevel::avx512,
+};
+
+// Sizes exercising full vectors of every width as well as the scalar tails
+const std::size_t sizes[] = {1, 3, 8, 17, 64, 100, 1023};
+
+const std::size_t inputSize = 13;
+const std::size_t outputSize = 5;
+const std::size_t testCount = 21;
+
+const char* simdName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::avx512:
+		return "avx512";
+	case SimdLevel::avx2:
+		return "avx2";
+	case SimdLevel::sse2:
+		return "sse2";
+	default:
+		return "none";
+	}
+}
+
+template<typename T>
+const char* typeName();
+
+template<>
+const char* typeName<float>() {
+	return "float";
+}
+
+template<>
+const char* typeName<double>() {
+	return "double";
+}
+
+template<typename T>
+double tolerance();
+
+template<>
+double tolerance<float>() {
+	return 1e-4;
+}
+
+template<>
+double tolerance<double>() {
+	return 1e-10;
+}
+
+template<typename T>
+std::vector<T> randomVector(std::size_t n, T low, T high, std::mt19937_64& engine) {
+	std::uniform_real_distribution<T> distribution(low, high);
+	std::vector<T> values(n);
+	for (auto& value : values) {
+		value = distribution(engine);
+	}
+	return values;
+}
+
+template<typename Q>
+std::vector<Q> randomIntegers(std::size_t n, std::mt19937_64& engine) {
+	std::uniform_int_distribution<int> distribution(-127, 127);
+	std::vector<Q> values(n);
+	for (auto& value : values) {
+		value = static_cast<Q>(distribution(engine));
+	}
+	return values;
+}
+
+template<class Container>
+void addOutput(std::vector<Output>& outputs, std::string name, const Container& values, double tolerance) {
+	outputs.push_back({std::move(name), std::vector<double>(values.begin(), values.end()), tolerance});
+}
+
+template<typename T, typename A = T>
+mlp::MultiLayerPerceptron<T, A> makePerceptron(std::mt19937_64& engine) {
+	mlp::MultiLayerPerceptron<T, A> perceptron(inputSize, {
+		{37, mlp::LogisticFunction<T>()},
+		{19, mlp::HyperbolicTangent<T>()},
+		{11, mlp::Rectifier<T>()},
+		{23, mlp::FastLogisticFunction<T>()},
+		{17, mlp::FastHyperbolicTangent<T>()},
+		{outputSize, mlp::IdentityFunction<T>()},
+	});
+	std::uniform_real_distribution<T> distribution(T(-0.5), T(0.5));
+	perceptron.generateWeights([&] { return distribution(engine); });
+	perceptron.generateBiases([&] { return distribution(engine); });
+	return perceptron;
+}
+
+template<class Perceptron, typename T>
+std::vector<T> testAll(const Perceptron& perceptron, const std::vector<T>& inputs) {
+	std::vector<T> output(testCount * outputSize);
+	for (std::size_t i = 0; i < testCount; ++i) {
+		perceptron.test(inputs.data() + i * inputSize, output.begin() + i * outputSize);
+	}
+	return output;
+}
+
+template<typename T, typename U>
+void runUpdates(std::size_t n, std::mt19937_64& engine, std::vector<Output>& outputs) {
+	const std::string suffix = "/" + std::string(typeName<U>()) + "/" + std::to_string(n);
+	const double eps = tolerance<T>();
+	const auto values = randomVector<T>(n, T(-1), T(1), engine);
+	const auto changes = randomVector<U>(n, U(-1), U(1), engine);
+	const auto state = randomVector<U>(n, U(0), U(1), engine);
+	auto y = values;
+	auto d = changes;
+	mlp::kernels::axpy(U(0.3), values.data(), d.data(), n);
+	addOutput(outputs, "axpy" + suffix, d, eps);
+	mlp::kernels::momentumUpdate(U(0.1), U(0.9), y.data(), d.data(), n);
+	addOutput(outputs, "momentumUpdate" + suffix, y, eps);
+	addOutput(outputs, "momentumUpdate/diffs" + suffix, d, eps);
+	y = values;
+	d = changes;
+	auto v = state;
+	mlp::kernels::nesterovUpdate(U(0.1), U(0.9), y.data(), d.data(), v.data(), n);
+	addOutput(outputs, "nesterovUpdate" + suffix, y, eps);
+	addOutput(outputs, "nesterovUpdate/velocities" + suffix, v, eps);
+	addOutput(outputs, "nesterovUpdate/changes" + suffix, d, 0.0);
+	y = values;
+	d = changes;
+	v = state;
+	mlp::kernels::rmsPropUpdate(U(0.01), U(0.9), U(1e-6), y.data(), d.data(), v.data(), n);
+	addOutput(outputs, "rmsPropUpdate" + suffix, y, eps);
+	addOutput(outputs, "rmsPropUpdate/squares" + suffix, v, eps);
+	y = values;
+	d = changes;
+	v = state;
+	auto m = changes;
+	mlp::kernels::adamUpdate(U(0.01), U(0.9), U(0.999), U(1e-6), y.data(), d.data(), m.data(), v.data(), n);
+	addOutput(outputs, "adamUpdate" + suffix, y, eps);
+	addOutput(outputs, "adamUpdate/moments" + suffix, m, eps);
+	addOutput(outputs, "adamUpdate/squares" + suffix, v, eps);
+}
+
+// Runs every kernel on the same pseudo-random arguments at the current SIMD
+// level and collects the results
+template<typename T>
+std::vector<Output> runKernels() {
+	namespace kernels = mlp::kernels;
+	const double eps = tolerance<T>();
+	std::mt19937_64 engine(7);
+	std::vector<Output> outputs;
+	for (std::size_t n : sizes) {
+		const std::string suffix = "/" + std::to_string(n);
+		const auto x = randomVector<T>(n, T(-1), T(1), engine);
+		const auto y = randomVector<T>(n, T(-1), T(1), engine);
+		addOutput(outputs, "dot" + suffix, std::vector<T>{kernels::dot(x.data(), y.data(), n)}, eps * std::sqrt(double(n)));
+		const auto a = randomIntegers<std::int8_t>(n, engine);
+		const auto b = randomIntegers<std::int8_t>(n, engine);
+		addOutput(outputs, "dot/int8" + suffix, std::vector<std::int32_t>{kernels::dot(a.data(), b.data(), n)}, 0.0);
+		const auto wide = randomVector<T>(n, T(-300), T(300), engine);
+		std::vector<std::int8_t> q(n);
+		kernels::quantize(wide.data(), n, T(1.5), q.data());
+		addOutput(outputs, "quantize" + suffix, q, 0.0);
+		std::vector<std::int16_t> q16(n);
+		kernels::quantize(wide.data(), n, T(0.75), q16.data());
+		addOutput(outputs, "quantize/int16" + suffix, q16, 0.0);
+		const auto arguments = randomVector<T>(n, T(-20), T(20), engine);
+		std::vector<T> result(n);
+		kernels::fastLogistic(arguments.data(), n, result.data());
+		addOutput(outputs, "fastLogistic" + suffix, result, eps);
+		kernels::fastTanh(arguments.data(), n, result.data());
+		addOutput(outputs, "fastTanh" + suffix, result, eps);
+		runUpdates<T, T>(n, engine, outputs);
+		if constexpr (std::is_same_v<T, float>) {
+			runUpdates<float, double>(n, engine, outputs);
+		}
+	}
+	const std::pair<std::size_t, std::size_t> shapes[] = {{1, 1}, {3, 5}, {8, 16}, {17, 33}, {64, 100}};
+	for (const auto& shape : shapes) {
+		const std::size_t rows = shape.first, cols = shape.second;
+		const std::string suffix = "/" + std::to_string(rows) + "x" + std::to_string(cols);
+		const auto matrix = randomVector<T>(rows * cols, T(-1), T(1), engine);
+		const auto bias = randomVector<T>(rows, T(-1), T(1), engine);
+		const auto scales = randomVector<T>(rows, T(0), T(0.01), engine);
+		const auto weights = randomIntegers<std::int8_t>(rows * cols, engine);
+		std::vector<std::int8_t> panels(kernels::packedSize(rows, cols));
+		kernels::packPanels(weights.data(), rows, cols, panels.data());
+		for (std::size_t count : {std::size_t(1), std::size_t(5), std::size_t(12)}) {
+			const auto x = randomVector<T>(count * cols, T(-1), T(1), engine);
+			std::vector<T> y(count * rows);
+			kernels::gemm(x.data(), count, matrix.data(), bias.data(), rows, cols, y.data());
+			addOutput(outputs, "gemm" + suffix + "x" + std::to_string(count), y, eps * std::sqrt(double(cols)));
+			const auto q = randomIntegers<std::int16_t>(count * cols, engine);
+			kernels::gemm(q.data(), count, panels.data(), scales.data(), bias.data(), rows, cols, y.data());
+			addOutput(outputs, "gemm/int8" + suffix + "x" + std::to_string(count), y, 0.0);
+		}
+		const auto x = randomVector<T>(cols, T(-1), T(1), engine);
+		std::vector<T> y(rows);
+		kernels::gemv(matrix.data(), bias.data(), x.data(), rows, cols, y.data());
+		addOutput(outputs, "gemv" + suffix, y, eps * std::sqrt(double(cols)));
+	}
+	return outputs;
+}
+
+// Runs inference and a training step of a perceptron at the current SIMD
+// level and collects the results
+template<typename T>
+std::vector<Output> runPerceptrons() {
+	const double eps = tolerance<T>();
+	std::mt19937_64 engine(11);
+	std::vector<Output> outputs;
+	auto perceptron = makePerceptron<T>(engine);
+	const auto inputs = randomVector<T>(testCount * inputSize, T(-1), T(1), engine);
+	const auto expected = randomVector<T>(testCount * outputSize, T(0), T(1), engine);
+	addOutput(outputs, "test", testAll(perceptron, inputs), eps);
+	std::vector<T> output(testCount * outputSize);
+	perceptron.testBatch(inputs.data(), testCount, output.begin());
+	addOutput(outputs, "testBatch", output, eps);
+	mlp::DataSet<T> calibration(inputSize, outputSize);
+	calibration.addTests(inputs.data(), expected.data(), testCount);
+	const mlp::QuantizedPerceptron<T> quantized(perceptron, calibration);
+	quantized.testBatch(inputs.data(), testCount, output.begin());
+	addOutput(outputs, "quantized/testBatch", output, eps);
+	for (std::size_t i = 0; i < testCount; ++i) {
+		perceptron.train(inputs.data() + i * inputSize, expected.data() + i * outputSize);
+	}
+	perceptron.apply(T(0.01), T(0.9));
+	perceptron.testBatch(inputs.data(), testCount, output.begin());
+	addOutput(outputs, "train", output, eps);
+	if constexpr (std::is_same_v<T, float>) {
+		auto mixed = makePerceptron<float, double>(engine);
+		for (std::size_t i = 0; i < testCount; ++i) {
+			mixed.train(inputs.data() + i * inputSize, expected.data() + i * outputSize);
+		}
+		mixed.apply(0.01, 0.9);
+		mixed.testBatch(inputs.data(), testCount, output.begin());
+		addOutput(outputs, "train/double", output, eps);
+	}
+	return outputs;
+}
+
+// Compares results of every SIMD level with those of the scalar code
+template<typename T, class Run>
+void checkLevels(Checker& checker, const char* name, Run run) {
+	const SimdLevel detected = mlp::kernels::detectSimdLevel();
+	mlp::kernels::setSimdLevel(SimdLevel::none);
+	const std::vector<Output> reference = run();
+	for (SimdLevel level : levels) {
+		if (level == SimdLevel::none || level > detected) {
+			continue;
+		}
+		mlp::kernels::setSimdLevel(level);
+		const std::vector<Output> candidate = run();
+		const std::string prefix = std::string(typeName<T>()) + "/" + simdName(level) + "/";
+		checker.check(candidate.size() == reference.size(), prefix + name);
+		for (std::size_t i = 0; i < std::min(reference.size(), candidate.size()); ++i) {
+			checker.compare(reference[i].values, candidate[i].values, reference[i].tolerance, prefix + reference[i].name);
+		}
+	}
+	mlp::kernels::setSimdLevel(detected);
+}
+
+std::string temporaryPath(const std::string& name) {
+	return (std::filesystem::temp_directory_path() / ("mlp_selfcheck_" + name)).string();
+}
+
+// Writes a model to a file and reads it back
+template<typename T>
+void checkModelFile(Checker& checker) {
+	const std::string prefix = std::string(typeName<T>()) + "/";
+	const std::string path = temporaryPath(prefix.substr(0, prefix.size() - 1) + ".model");
+	std::mt19937_64 engine(13);
+	const auto perceptron = makePerceptron<T>(engine);
+	const auto inputs = randomVector<T>(testCount * inputSize, T(-1), T(1), engine);
+	try {
+		mlp::saveModel(perceptron, path);
+		const auto loaded = mlp::loadModel<T>(path);
+		checker.check(testAll(loaded, inputs) == testAll(perceptron, inputs), prefix + "loadModel");
+		const mlp::MappedPerceptron<T> mapped(path);
+		checker.check(testAll(mapped, inputs) == testAll(perceptron, inputs), prefix + "MappedPerceptron");
+	} catch (const std::exception& e) {
+		checker.check(false, prefix + "model file: " + e.what());
+	}
+	std::error_code error;
+	std::filesystem::remove(path, error);
+}
+
+// Writes a data set to a file and maps it
+template<typename T>
+void checkDataSetFile(Checker& checker) {
+	const std::string prefix = std::string(typeName<T>()) + "/";
+	const std::string path = temporaryPath(prefix.substr(0, prefix.size() - 1) + ".data");
+	std::mt19937_64 engine(17);
+	const auto inputs = randomVector<T>(testCount * inputSize, T(-1), T(1), engine);
+	const auto expected = randomVector<T>(testCount * outputSize, T(0), T(1), engine);
+	mlp::DataSet<T> data(inputSize, outputSize);
+	data.addTests(inputs.data(), expected.data(), testCount);
+	try {
+		mlp::saveDataSet(data, path);
+		const mlp::MappedDataSet<T> mapped(path);
+		bool equal = mapped.size() == data.size() && mapped.inputSize() == inputSize && mapped.outputSize() == outputSize;
+		for (std::size_t i = 0; equal && i < data.size(); ++i) {
+			equal = std::equal(data.input(i), data.input(i) + inputSize, mapped.input(i))
+				&& std::equal(data.output(i), data.output(i) + outputSize, mapped.output(i));
+		}
+		checker.check(equal, prefix + "MappedDataSet");
+	} catch (const std::exception& e) {
+		checker.check(false, prefix + "data set file: " + e.what());
+	}
+	std::error_code error;
+	std::filesystem::remove(path, error);
+}
+
+// Trains a perceptron with and without prefetching and compares the results
+template<typename T>
+void checkPrefetch(Checker& checker) {
+	std::mt19937_64 engine(29);
+	const auto inputs = randomVector<T>(testCount * inputSize, T(-1), T(1), engine);
+	const auto expected = randomVector<T>(testCount * outputSize, T(0), T(1), engine);
+	mlp::PerceptronTrainer<T> trainer(inputSize, outputSize);
+	trainer.addTests(inputs.data(), expected.data(), testCount);
+	trainer.setMaxEpochs(20);
+	trainer.setInitialWeightRange(T(0.5));
+	trainer.setLearningRate(T(0.01));
+	trainer.setMomentum(T(0.9));
+	trainer.setBatchSize(4);
+	trainer.setSeed(7);
+	std::vector<T> outputs[2];
+	double errors[2];
+	for (std::size_t prefetch = 0; prefetch < 2; ++prefetch) {
+		trainer.setPrefetchCount(2 * prefetch);
+		std::mt19937_64 biasEngine(31);
+		auto perceptron = makePerceptron<T>(biasEngine);
+		errors[prefetch] = trainer.train(perceptron).error;
+		outputs[prefetch] = testAll(perceptron, inputs);
+	}
+	checker.check(errors[0] == errors[1] && outputs[0] == outputs[1], std::string(typeName<T>()) + "/prefetch");
+}
+
+// Trains on an empty data set with every training method, which must report
+// no epochs and an error of 0
+template<typename T>
+void checkEmptyTraining(Checker& checker) {
+	mlp::PerceptronTrainer<T> trainer(inputSize, outputSize);
+	trainer.setMaxEpochs(20);
+	trainer.setInitialWeightRange(T(0.5));
+	trainer.setLearningRate(T(0.01));
+	trainer.setSeed(7);
+	const std::pair<mlp::TrainingMethod, const char*> methods[] = {
+		{mlp::TrainingMethod::gradientDescent, "gradientDescent"},
+		{mlp::TrainingMethod::lbfgs, "lbfgs"},
+	};
+	for (const auto& method : methods) {
+		trainer.setMethod(method.first);
+		std::mt19937_64 engine(37);
+		auto perceptron = makePerceptron<T>(engine);
+		const auto report = trainer.train(perceptron);
+		checker.check(report.epochs == 0 && report.error == 0.0 && !report.converged, std::string(typeName<T>()) + "/empty/" + method.second);
+	}
+}
+
+// Compares a StaticPerceptron with the perceptron it was built from
+template<typename T>
+void checkStatic(Checker& checker) {
+	using Activations = std::tuple<mlp::LogisticFunction<T>, mlp::HyperbolicTangent<T>, mlp::Rectifier<T>, mlp::FastLogisticFunction<T>, mlp::FastHyperbolicTangent<T>, mlp::IdentityFunction<T>>;
+	using Perceptron = mlp::StaticPerceptron<T, Activations, inputSize, 37, 19, 11, 23, 17, outputSize>;
+	std::mt19937_64 engine(19);
+	const auto perceptron = makePerceptron<T>(engine);
+	const Perceptron converted(perceptron);
+	const auto inputs = randomVector<T>(testCount * inputSize, T(-1), T(1), engine);
+	checker.compare(testAll(perceptron, inputs), testAll(converted, inputs), tolerance<T>(), std::string(typeName<T>()) + "/StaticPerceptron");
+}
+
+// Generates headers with names that are keywords, reserved or otherwise
+// invalid, which must be rejected, and with a valid name, which must not
+template<typename T>
+void checkHeaderNames(Checker& checker) {
+	std::mt19937_64 engine(41);
+	const auto perceptron = makePerceptron<T>(engine);
+	const std::string prefix = std::string(typeName<T>()) + "/generateHeader/";
+	for (const char* name : {"", "1net", "net-1", "int", "class", "and", "co_await", "_Net", "_net", "net__1"}) {
+		std::ostringstream out;
+		bool rejected = false;
+		try {
+			mlp::generateHeader(perceptron, name, out);
+		} catch (const std::invalid_argument&) {
+			rejected = true;
+		}
+		checker.check(rejected, prefix + "reject '" + name + "'");
+	}
+	std::ostringstream out;
+	bool accepted = true;
+	try {
+		mlp::generateHeader(perceptron, "net_1", out);
+	} catch (const std::invalid_argument&) {
+		accepted = false;
+	}
+	checker.check(accepted, prefix + "accept 'net_1'");
+}
+
+// Generates a header from a perceptron, compiles a program writing the
+// output of the header's infer function for a set of inputs and compares
+// that output with the output of the perceptron
+template<typename T>
+void checkGeneratedHeader(Checker& checker, const std::string& compiler) {
+	const std::string prefix = std::string(typeName<T>()) + "/";
+	const std::string base = temporaryPath(prefix.substr(0, prefix.size() - 1) + "_network");
+	const std::string header = base + ".h", source = base + ".cpp", program = base, output = base + ".txt";
+	std::mt19937_64 engine(23);
+	const auto perceptron = makePerceptron<T>(engine);
+	const auto inputs = randomVector<T>(testCount * inputSize, T(-1), T(1), engine);
+	try {
+		mlp::generateHeader(perceptron, "network", header);
+		std::ofstream out(source);
+		out << "#include <cstddef>\n#include <cstdio>\n#include \"" << header << "\"\n\n";
+		out << "const network::ValueType inputs[" << inputs.size() << "] = {";
+		for (std::size_t i = 0; i < inputs.size(); ++i) {
+			out << (i % 4 == 0 ? "\n\t" : " ");
+			mlp::headerGenerator::writeLiteral(out, inputs[i]);
+			out << ",";
+		}
+		out << "\n};\n\nint main() {\n";
+		out << "\tnetwork::ValueType output[network::outputSize];\n";
+		out << "\tfor (std::size_t i = 0; i < " << testCount << "; ++i) {\n";
+		out << "\t\tnetwork::infer(inputs + i * network::inputSize, output);\n";
+		out << "\t\tfor (std::size_t j = 0; j < network::outputSize; ++j) {\n";
+		out << "\t\t\tstd::printf(\"%.17g\\n\", double(output[j]));\n";
+		out << "\t\t}\n\t}\n\treturn 0;\n}\n";
+		out.close();
+		const std::string build = compiler + " -std=c++17 -O1 -o \"" + program + "\" \"" + source + "\"";
+		const bool compiled = out && std::system(build.c_str()) == 0;
+		checker.check(compiled, prefix + "generateHeader/compile");
+		if (compiled) {
+			const std::string command = "\"" + program + "\" > \"" + output + "\"";
+			checker.check(std::system(command.c_str()) == 0, prefix + "generateHeader/run");
+			std::ifstream in(output);
+			std::vector<double> values;
+			for (double value; in >> value;) {
+				values.push_back(value);
+			}
+			const auto expected = testAll(perceptron, inputs);
+			checker.compare(std::vector<double>(expected.begin(), expected.end()), values, tolerance<T>(), prefix + "generateHeader");
+		}
+	} catch (const std::exception& e) {
+		checker.check(false, prefix + "generateHeader: " + e.what());
+	}
+	std::error_code error;
+	for (const auto& path : {header, source, program, output}) {
+		std::filesystem::remove(path, error);
+	}
+}
+
+template<typename T>
+void run(Checker& checker, const std::string& compiler) {
+	checkLevels<T>(checker, "kernels", runKernels<T>);
+	checkLevels<T>(checker, "perceptrons", runPerceptrons<T>);
+	checkModelFile<T>(checker);
+	checkDataSetFile<T>(checker);
+	checkPrefetch<T>(checker);
+	checkEmptyTraining<T>(checker);
+	checkStatic<T>(checker);
+	checkHeaderNames<T>(checker);
+	if (!compiler.empty()) {
+		checkGeneratedHeader<T>(checker, compiler);
+	}
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	std::string compiler = "c++";
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument.compare(0, 11, "--compiler=") == 0) {
+			compiler = argument.substr(11);
+		} else {
+			std::cerr << "usage: " << argv[0] << " [--compiler=command]" << std::endl;
+			return 1;
+		}
+	}
+	std::cout << "SIMD level: " << simdName(mlp::kernels::detectSimdLevel()) << std::endl;
+	Checker checker;
+	run<float>(checker, compiler);
+	run<double>(checker, compiler);
+	return checker.summarize();
+}